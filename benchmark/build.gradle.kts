@@ -0,0 +1,32 @@
+import org.jetbrains.kotlin.gradle.tasks.KotlinCompile
+
+plugins {
+    application
+    kotlin("jvm")
+}
+
+group = rootProject.group
+version = rootProject.version
+
+evaluationDependsOn(":leveldb-kt")
+
+application {
+    mainClass.set("com.edwardstock.leveldb.benchmark.MainKt")
+}
+
+tasks.withType<KotlinCompile> {
+    kotlinOptions {
+        jvmTarget = "1.8"
+    }
+}
+
+// Runs against the native library leveldb-kt builds, with the same library path as its tests.
+tasks.named<JavaExec>("run") {
+    dependsOn(":leveldb-kt:buildCMake")
+    val leveldbTests = project(":leveldb-kt").tasks.named<Test>("test").get()
+    jvmArgs(leveldbTests.allJvmArgs.filter { it.startsWith("-Djava.library.path=") })
+}
+
+dependencies {
+    implementation(project(":leveldb-kt"))
+}
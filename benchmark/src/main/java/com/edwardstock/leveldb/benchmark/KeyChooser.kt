@@ -0,0 +1,92 @@
+package com.edwardstock.leveldb.benchmark
+
+import java.util.concurrent.ThreadLocalRandom
+import kotlin.math.pow
+
+/**
+ * Chooses the number of the record an operation touches, among the records inserted so far.
+ */
+interface KeyChooser {
+    /**
+     * @param lastInserted number of the most recently inserted record
+     */
+    fun next(lastInserted: Long): Long
+
+    companion object {
+        fun create(distribution: Distribution, records: Long): KeyChooser {
+            return when (distribution) {
+                Distribution.UNIFORM -> UniformKeyChooser()
+                Distribution.ZIPFIAN -> ScrambledZipfianKeyChooser(records)
+                Distribution.LATEST -> LatestKeyChooser(records)
+            }
+        }
+    }
+}
+
+class UniformKeyChooser : KeyChooser {
+    override fun next(lastInserted: Long): Long {
+        return ThreadLocalRandom.current().nextLong(lastInserted + 1)
+    }
+}
+
+/**
+ * Zipfian numbers in [0, items), 0 most popular, after Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases". Setup sums over all items once, generating is constant time.
+ */
+class ZipfianGenerator(private val items: Long, private val theta: Double = ZIPFIAN_CONSTANT) {
+    private val zetan = zeta(items, theta)
+    private val alpha = 1.0 / (1.0 - theta)
+    private val eta = (1 - (2.0 / items).pow(1 - theta)) / (1 - zeta(2, theta) / zetan)
+    private val secondThreshold = 1 + 0.5.pow(theta)
+
+    init {
+        require(items > 0) { "No items to choose from" }
+    }
+
+    fun next(): Long {
+        val u = ThreadLocalRandom.current().nextDouble()
+        val uz = u * zetan
+        if (uz < 1.0) {
+            return 0
+        }
+        if (uz < secondThreshold) {
+            return 1
+        }
+        return (items * (eta * u - eta + 1).pow(alpha)).toLong().coerceAtMost(items - 1)
+    }
+
+    companion object {
+        const val ZIPFIAN_CONSTANT = 0.99
+
+        private fun zeta(n: Long, theta: Double): Double {
+            var sum = 0.0
+            for (i in 1..n) {
+                sum += 1.0 / i.toDouble().pow(theta)
+            }
+            return sum
+        }
+    }
+}
+
+/**
+ * Zipfian over the initially loaded records, with the popular ones spread over the key space by hashing,
+ * so that hot records don't all sit in the same blocks. Records inserted later are never chosen.
+ */
+class ScrambledZipfianKeyChooser(private val records: Long) : KeyChooser {
+    private val zipfian = ZipfianGenerator(records)
+
+    override fun next(lastInserted: Long): Long {
+        return Math.floorMod(Keys.fnv64(zipfian.next()), records)
+    }
+}
+
+/**
+ * Zipfian by age: the most recently inserted record is the most popular one.
+ */
+class LatestKeyChooser(records: Long) : KeyChooser {
+    private val zipfian = ZipfianGenerator(records)
+
+    override fun next(lastInserted: Long): Long {
+        return (lastInserted - zipfian.next()).coerceAtLeast(0)
+    }
+}
@@ -0,0 +1,27 @@
+package com.edwardstock.leveldb.benchmark
+
+object Keys {
+    private const val FNV_OFFSET_BASIS = -0x340d631b7bdddcdbL
+    private const val FNV_PRIME = 0x100000001b3L
+
+    /**
+     * Key of record [n]. Record numbers are hashed, like YCSB does, so that inserts don't go in key order.
+     */
+    fun key(n: Long): ByteArray {
+        return ("user" + java.lang.Long.toUnsignedString(fnv64(n)).padStart(20, '0')).toByteArray()
+    }
+
+    /**
+     * FNV-1a of the 8 bytes of [value].
+     */
+    fun fnv64(value: Long): Long {
+        var hash = FNV_OFFSET_BASIS
+        var v = value
+        for (i in 0 until 8) {
+            hash = hash xor (v and 0xff)
+            hash *= FNV_PRIME
+            v = v ushr 8
+        }
+        return hash
+    }
+}
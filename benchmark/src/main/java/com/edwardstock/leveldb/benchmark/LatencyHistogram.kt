@@ -0,0 +1,80 @@
+package com.edwardstock.leveldb.benchmark
+
+/**
+ * Latencies in nanoseconds, in log-linear buckets: exact below 32 ns, within 1/16 above. Recording doesn't
+ * allocate. Not thread safe, every worker keeps its own and they're [merged][add] at the end.
+ */
+class LatencyHistogram {
+    private val buckets = LongArray(BUCKETS)
+
+    var count = 0L
+        private set
+    var maxNanos = 0L
+        private set
+    private var sumNanos = 0.0
+
+    val meanNanos: Double
+        get() = if (count == 0L) 0.0 else sumNanos / count
+
+    fun record(nanos: Long) {
+        val value = nanos.coerceAtLeast(0)
+        buckets[index(value)]++
+        count++
+        sumNanos += value
+        if (value > maxNanos) {
+            maxNanos = value
+        }
+    }
+
+    fun add(other: LatencyHistogram) {
+        for (i in buckets.indices) {
+            buckets[i] += other.buckets[i]
+        }
+        count += other.count
+        sumNanos += other.sumNanos
+        maxNanos = maxOf(maxNanos, other.maxNanos)
+    }
+
+    /**
+     * Latency below which [percentile] percent of the recorded ones are, in nanoseconds.
+     */
+    fun percentileNanos(percentile: Double): Long {
+        if (count == 0L) {
+            return 0
+        }
+        val rank = Math.ceil(count * percentile / 100.0).toLong().coerceIn(1, count)
+        var seen = 0L
+        for (i in buckets.indices) {
+            seen += buckets[i]
+            if (seen >= rank) {
+                return minOf(value(i), maxNanos)
+            }
+        }
+        return maxNanos
+    }
+
+    private companion object {
+        const val SUB_BITS = 4
+        const val SUB_BUCKETS = 1 shl SUB_BITS
+        const val LINEAR = 2 * SUB_BUCKETS
+        const val BUCKETS = 64 * SUB_BUCKETS
+
+        fun index(value: Long): Int {
+            if (value < LINEAR) {
+                return value.toInt()
+            }
+            val shift = 63 - java.lang.Long.numberOfLeadingZeros(value) - SUB_BITS
+            return shift * SUB_BUCKETS + (value ushr shift).toInt()
+        }
+
+        // Middle of the bucket.
+        fun value(index: Int): Long {
+            if (index < LINEAR) {
+                return index.toLong()
+            }
+            val shift = index / SUB_BUCKETS - 1
+            val top = (index % SUB_BUCKETS + SUB_BUCKETS).toLong()
+            return (top shl shift) + (1L shl shift) / 2
+        }
+    }
+}
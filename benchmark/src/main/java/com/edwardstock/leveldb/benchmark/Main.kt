@@ -0,0 +1,192 @@
+package com.edwardstock.leveldb.benchmark
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import java.io.File
+import java.io.OutputStreamWriter
+import kotlin.system.exitProcess
+
+private const val USAGE = """Runs YCSB-style workloads on NativeLevelDB with increasing thread counts and reports
+throughput and latency percentiles per thread count and operation.
+
+Usage: benchmark [--option=value ...]
+  --workloads=A,B,...       core YCSB workloads A-F to run, default A
+  --read=P --update=P --insert=P --scan=P --rmw=P
+                            custom operation mix instead of --workloads
+  --distribution=D          uniform, zipfian or latest, overrides the workloads' one
+  --max-scan-length=N       default 100
+  --records=N               records loaded before every workload, default 100000
+  --operations=N            operations per thread count, default 100000
+  --value-size=BYTES        default 1000
+  --threads=N               runs with 1, 2, 4, ... and N threads, default: number of processors
+  --thread-counts=1,3,8     runs with exactly these thread counts
+  --cache-size=BYTES --block-size=BYTES --write-buffer-size=BYTES --row-cache-size=BYTES
+  --readahead-size=BYTES --throttle-writes
+                            LevelDB.Config of the database
+  --in-memory               opens the database in memory
+  --path=DIR                database directory, default a temporary one deleted afterwards
+  --format=csv|json         default csv
+  --output=FILE             default standard output
+"""
+
+fun main(args: Array<String>) {
+    val options = parseOptions(args)
+    if ("help" in options) {
+        print(USAGE)
+        return
+    }
+
+    val records = options.long("records", 100_000)
+    val operations = options.long("operations", 100_000)
+    val valueSize = options.int("value-size", 1000)
+    val threadCounts = options["thread-counts"]?.split(',')?.map { it.trim().toInt() }
+        ?: sweep(options.int("threads", Runtime.getRuntime().availableProcessors()))
+    val workloads = workloads(options)
+
+    val config = LevelDB.Config(
+        createIfMissing = true,
+        cacheSize = options.int("cache-size", 0),
+        blockSize = options.int("block-size", 0),
+        writeBufferSize = options.int("write-buffer-size", 0),
+        rowCacheSize = options.int("row-cache-size", 0),
+        readaheadSize = options.int("readahead-size", 0),
+        throttleWrites = "throttle-writes" in options
+    )
+    val inMemory = "in-memory" in options
+
+    val settings = linkedMapOf<String, Any>(
+        "records" to records,
+        "operations" to operations,
+        "value_size" to valueSize,
+        "cache_size" to config.cacheSize,
+        "block_size" to config.blockSize,
+        "write_buffer_size" to config.writeBufferSize,
+        "row_cache_size" to config.rowCacheSize,
+        "readahead_size" to config.readaheadSize,
+        "throttle_writes" to config.throttleWrites,
+        "in_memory" to inMemory
+    )
+
+    val output = options["output"]?.let { File(it).outputStream() } ?: System.out
+    val writer = OutputStreamWriter(output, Charsets.UTF_8)
+
+    val report = when (options["format"] ?: "csv") {
+        "csv" -> CsvReport(writer, settings)
+        "json" -> JsonReport(writer, settings)
+        else -> fail("Unknown format ${options["format"]}")
+    }
+
+    report.begin()
+    for (workload in workloads) {
+        runWorkload(workload, config, inMemory, options["path"], records, operations, valueSize, threadCounts, report)
+    }
+    report.end()
+
+    if (output !== System.out) {
+        writer.close()
+    }
+}
+
+private fun runWorkload(
+    workload: Workload,
+    config: LevelDB.Config,
+    inMemory: Boolean,
+    path: String?,
+    records: Long,
+    operations: Long,
+    valueSize: Int,
+    threadCounts: List<Int>,
+    report: Report
+) {
+    val directory = path?.let { File(it) } ?: File.createTempFile("leveldb-benchmark", "").also { it.delete() }
+    val db = if (inMemory) LevelDB.openInMemory(config) else NativeLevelDB(directory.absolutePath, config)
+
+    try {
+        val runner = Runner(db, records, valueSize)
+
+        log("Workload ${workload.name}: loading $records records")
+        runner.load(threadCounts.maxOrNull() ?: 1)
+
+        for (threads in threadCounts) {
+            val result = runner.run(workload, threads, operations)
+            log("Workload ${workload.name}, $threads threads: ${result.throughput.toLong()} ops/s")
+            report.add(result)
+        }
+    } finally {
+        db.close()
+        if (!inMemory && path == null) {
+            LevelDB.destroy(directory.absolutePath)
+            directory.deleteRecursively()
+        }
+    }
+}
+
+private fun workloads(options: Map<String, String>): List<Workload> {
+    val distribution = options["distribution"]?.let { Distribution.valueOf(it.uppercase()) }
+    val maxScanLength = options.int("max-scan-length", 100)
+    val mixKeys = listOf("read", "update", "insert", "scan", "rmw")
+
+    val workloads = if (mixKeys.any { it in options }) {
+        listOf(
+            Workload(
+                name = "custom",
+                readProportion = options.double("read"),
+                updateProportion = options.double("update"),
+                insertProportion = options.double("insert"),
+                scanProportion = options.double("scan"),
+                readModifyWriteProportion = options.double("rmw")
+            )
+        )
+    } else {
+        (options["workloads"] ?: "A").split(',').map { name ->
+            Workload.STANDARD[name.trim().uppercase()] ?: fail("Unknown workload $name")
+        }
+    }
+
+    return workloads.map { workload ->
+        workload.copy(
+            distribution = distribution ?: workload.distribution,
+            maxScanLength = maxScanLength
+        )
+    }
+}
+
+// 1, 2, 4, ... and max.
+private fun sweep(max: Int): List<Int> {
+    val counts = generateSequence(1) { it * 2 }.takeWhile { it < max }.toMutableList()
+    counts.add(max)
+    return counts
+}
+
+private fun parseOptions(args: Array<String>): Map<String, String> {
+    return args.associate { arg ->
+        if (!arg.startsWith("--")) {
+            fail("Unexpected argument $arg")
+        }
+        val option = arg.removePrefix("--")
+        val separator = option.indexOf('=')
+        if (separator < 0) option to "" else option.substring(0, separator) to option.substring(separator + 1)
+    }
+}
+
+private fun Map<String, String>.int(name: String, default: Int): Int {
+    return this[name]?.let { it.toIntOrNull() ?: fail("--$name must be a number") } ?: default
+}
+
+private fun Map<String, String>.long(name: String, default: Long): Long {
+    return this[name]?.let { it.toLongOrNull() ?: fail("--$name must be a number") } ?: default
+}
+
+private fun Map<String, String>.double(name: String): Double {
+    return this[name]?.let { it.toDoubleOrNull() ?: fail("--$name must be a number") } ?: 0.0
+}
+
+private fun log(message: String) {
+    System.err.println(message)
+}
+
+private fun fail(message: String): Nothing {
+    System.err.println(message)
+    System.err.print(USAGE)
+    exitProcess(1)
+}
@@ -0,0 +1,108 @@
+package com.edwardstock.leveldb.benchmark
+
+import java.io.Writer
+import java.math.BigDecimal
+import java.util.Locale
+
+/**
+ * Writes results, one row per workload, thread count and operation plus an ALL row per workload and thread
+ * count, along with the settings of the run so that reports of different settings can be compared.
+ */
+abstract class Report(protected val out: Writer, protected val settings: Map<String, Any>) {
+    abstract fun begin()
+    abstract fun add(result: RunResult)
+    abstract fun end()
+
+    protected fun rows(result: RunResult): List<Pair<String, LatencyHistogram>> {
+        return listOf("ALL" to result.overall) + result.latencies.map { (operation, histogram) ->
+            operation.name to histogram
+        }
+    }
+
+    protected fun micros(nanos: Long): String = format(nanos / 1000.0)
+
+    protected fun format(value: Double): String = String.format(Locale.US, "%.2f", value)
+
+    companion object {
+        val PERCENTILES = listOf(50.0, 95.0, 99.0, 99.9)
+
+        // p50, p999 and so on.
+        fun percentileName(percentile: Double): String {
+            return "p" + BigDecimal.valueOf(percentile).stripTrailingZeros().toPlainString().replace(".", "")
+        }
+    }
+}
+
+class CsvReport(out: Writer, settings: Map<String, Any>) : Report(out, settings) {
+    override fun begin() {
+        val columns = settings.keys + listOf("workload", "distribution", "threads", "operation", "count", "ops_per_sec", "mean_us") +
+                PERCENTILES.map { percentileName(it) + "_us" } + "max_us"
+        out.write(columns.joinToString(",") + "\n")
+    }
+
+    override fun add(result: RunResult) {
+        for ((operation, histogram) in rows(result)) {
+            val throughput = histogram.count * 1e9 / result.elapsedNanos
+            val values = settings.values.map { it.toString() } + listOf(
+                result.workload.name,
+                result.workload.distribution.name.lowercase(),
+                result.threads.toString(),
+                operation,
+                histogram.count.toString(),
+                format(throughput),
+                format(histogram.meanNanos / 1000.0)
+            ) + PERCENTILES.map { micros(histogram.percentileNanos(it)) } + micros(histogram.maxNanos)
+            out.write(values.joinToString(",") + "\n")
+        }
+        out.flush()
+    }
+
+    override fun end() {
+        out.flush()
+    }
+}
+
+class JsonReport(out: Writer, settings: Map<String, Any>) : Report(out, settings) {
+    private var first = true
+
+    override fun begin() {
+        out.write("{\n  \"settings\": {")
+        out.write(settings.entries.joinToString(", ") { (key, value) -> "\"$key\": ${json(value)}" })
+        out.write("},\n  \"results\": [")
+    }
+
+    override fun add(result: RunResult) {
+        for ((operation, histogram) in rows(result)) {
+            out.write(if (first) "\n    " else ",\n    ")
+            first = false
+
+            val fields = linkedMapOf<String, Any>(
+                "workload" to result.workload.name,
+                "distribution" to result.workload.distribution.name.lowercase(),
+                "threads" to result.threads,
+                "operation" to operation,
+                "count" to histogram.count,
+                "opsPerSec" to histogram.count * 1e9 / result.elapsedNanos,
+                "meanUs" to histogram.meanNanos / 1000.0
+            )
+            PERCENTILES.forEach { fields[percentileName(it) + "Us"] = histogram.percentileNanos(it) / 1000.0 }
+            fields["maxUs"] = histogram.maxNanos / 1000.0
+
+            out.write("{" + fields.entries.joinToString(", ") { (key, value) -> "\"$key\": ${json(value)}" } + "}")
+        }
+        out.flush()
+    }
+
+    override fun end() {
+        out.write("\n  ]\n}\n")
+        out.flush()
+    }
+
+    private fun json(value: Any): String {
+        return when (value) {
+            is Double -> format(value)
+            is Number, is Boolean -> value.toString()
+            else -> "\"" + value.toString().replace("\\", "\\\\").replace("\"", "\\\"") + "\""
+        }
+    }
+}
@@ -0,0 +1,162 @@
+package com.edwardstock.leveldb.benchmark
+
+import com.edwardstock.leveldb.LevelDB
+import java.util.EnumMap
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.ThreadLocalRandom
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReference
+
+/**
+ * Result of running a workload with a number of threads.
+ */
+class RunResult(
+    val workload: Workload,
+    val threads: Int,
+    val elapsedNanos: Long,
+    val latencies: Map<Operation, LatencyHistogram>
+) {
+    val operations: Long
+        get() = latencies.values.sumOf { it.count }
+
+    val throughput: Double
+        get() = operations * 1e9 / elapsedNanos
+
+    val overall: LatencyHistogram
+        get() = LatencyHistogram().also { all -> latencies.values.forEach(all::add) }
+}
+
+/**
+ * Loads records into [db] and runs workloads on them, timing every operation.
+ */
+class Runner(
+    private val db: LevelDB,
+    private val records: Long,
+    private val valueSize: Int
+) {
+    // Number of the next record to insert, records before it have been inserted or are being inserted.
+    private val nextInsert = AtomicLong(0)
+
+    /**
+     * Inserts the initial [records] with [threads] threads.
+     */
+    fun load(threads: Int) {
+        nextInsert.set(0)
+        runThreads(threads) {
+            val value = newValue()
+            while (true) {
+                val n = nextInsert.getAndIncrement()
+                if (n >= records) {
+                    break
+                }
+                write(n, value)
+            }
+        }
+        nextInsert.set(records)
+    }
+
+    /**
+     * Runs [operations] operations of [workload], split over [threads] threads.
+     */
+    fun run(workload: Workload, threads: Int, operations: Long): RunResult {
+        val chooser = KeyChooser.create(workload.distribution, records)
+        val perThread = Array(threads) { EnumMap<Operation, LatencyHistogram>(Operation::class.java) }
+
+        val elapsed = runThreads(threads) { thread ->
+            val latencies = perThread[thread]
+            Operation.values().forEach { latencies[it] = LatencyHistogram() }
+
+            val random = ThreadLocalRandom.current()
+            val value = newValue()
+            val count = operations / threads + if (thread < operations % threads) 1 else 0
+
+            for (i in 0 until count) {
+                val operation = workload.choose(random.nextDouble())
+                val start = System.nanoTime()
+                when (operation) {
+                    Operation.READ -> db.get(Keys.key(chooser.next(lastInserted())))
+                    Operation.UPDATE -> write(chooser.next(lastInserted()), value)
+                    Operation.INSERT -> write(nextInsert.getAndIncrement(), value)
+                    Operation.SCAN -> scan(chooser.next(lastInserted()), random.nextInt(workload.maxScanLength) + 1)
+                    Operation.READ_MODIFY_WRITE -> {
+                        val n = chooser.next(lastInserted())
+                        db.get(Keys.key(n))
+                        write(n, value)
+                    }
+                }
+                latencies[operation]!!.record(System.nanoTime() - start)
+            }
+        }
+
+        val merged = EnumMap<Operation, LatencyHistogram>(Operation::class.java)
+        for (operation in Operation.values()) {
+            val histogram = LatencyHistogram()
+            perThread.forEach { histogram.add(it[operation]!!) }
+            if (histogram.count > 0) {
+                merged[operation] = histogram
+            }
+        }
+        return RunResult(workload, threads, elapsed, merged)
+    }
+
+    private fun lastInserted(): Long {
+        return (nextInsert.get() - 1).coerceAtLeast(0)
+    }
+
+    private fun newValue(): ByteArray {
+        return ByteArray(valueSize).also { ThreadLocalRandom.current().nextBytes(it) }
+    }
+
+    private fun write(n: Long, value: ByteArray) {
+        // Values differ without generating new random bytes for every write.
+        if (value.size >= 8) {
+            for (i in 0 until 8) {
+                value[i] = (n ushr (i * 8)).toByte()
+            }
+        }
+        db.put(Keys.key(n), value)
+    }
+
+    private fun scan(n: Long, length: Int) {
+        db.iterator().use { iterator ->
+            iterator.seek(Keys.key(n))
+            var read = 0
+            while (read < length && iterator.isValid) {
+                iterator.key()
+                iterator.value()
+                iterator.next()
+                read++
+            }
+        }
+    }
+
+    /**
+     * Runs [block] on [threads] threads started at the same time, returns the nanoseconds until all finished.
+     */
+    private fun runThreads(threads: Int, block: (Int) -> Unit): Long {
+        val ready = CountDownLatch(threads)
+        val go = CountDownLatch(1)
+        val failure = AtomicReference<Throwable>()
+
+        val workers = (0 until threads).map { thread ->
+            Thread({
+                ready.countDown()
+                go.await()
+                try {
+                    block(thread)
+                } catch (e: Throwable) {
+                    failure.compareAndSet(null, e)
+                }
+            }, "benchmark-$thread").apply { start() }
+        }
+
+        ready.await()
+        val start = System.nanoTime()
+        go.countDown()
+        workers.forEach { it.join() }
+        val elapsed = System.nanoTime() - start
+
+        failure.get()?.let { throw it }
+        return elapsed
+    }
+}
@@ -0,0 +1,87 @@
+package com.edwardstock.leveldb.benchmark
+
+/**
+ * How the records an operation touches are chosen.
+ */
+enum class Distribution {
+    /**
+     * Every record equally likely.
+     */
+    UNIFORM,
+
+    /**
+     * Few records are hot, scattered over the key space.
+     */
+    ZIPFIAN,
+
+    /**
+     * Recently inserted records are hot.
+     */
+    LATEST
+}
+
+/**
+ * Mix of operations of a run. Proportions are relative to their sum.
+ * @property maxScanLength scans read between 1 and this many records
+ */
+data class Workload(
+    val name: String,
+    val readProportion: Double = 0.0,
+    val updateProportion: Double = 0.0,
+    val insertProportion: Double = 0.0,
+    val scanProportion: Double = 0.0,
+    val readModifyWriteProportion: Double = 0.0,
+    val distribution: Distribution = Distribution.ZIPFIAN,
+    val maxScanLength: Int = 100
+) {
+    init {
+        require(total > 0) { "Workload $name has no operations" }
+    }
+
+    private val total: Double
+        get() = readProportion + updateProportion + insertProportion + scanProportion + readModifyWriteProportion
+
+    /**
+     * Picks an operation for [random], uniform in [0, 1).
+     */
+    fun choose(random: Double): Operation {
+        var threshold = random * total
+        threshold -= readProportion
+        if (threshold < 0) return Operation.READ
+        threshold -= updateProportion
+        if (threshold < 0) return Operation.UPDATE
+        threshold -= insertProportion
+        if (threshold < 0) return Operation.INSERT
+        threshold -= scanProportion
+        if (threshold < 0) return Operation.SCAN
+        return Operation.READ_MODIFY_WRITE
+    }
+
+    companion object {
+        /**
+         * The core YCSB workloads.
+         */
+        val STANDARD: Map<String, Workload> = listOf(
+            // Update heavy: session stores.
+            Workload("A", readProportion = 0.5, updateProportion = 0.5),
+            // Read mostly: photo tagging.
+            Workload("B", readProportion = 0.95, updateProportion = 0.05),
+            // Read only: user profile caches.
+            Workload("C", readProportion = 1.0),
+            // Read latest: status updates.
+            Workload("D", readProportion = 0.95, insertProportion = 0.05, distribution = Distribution.LATEST),
+            // Short ranges: threaded conversations.
+            Workload("E", scanProportion = 0.95, insertProportion = 0.05),
+            // Read-modify-write: user databases.
+            Workload("F", readProportion = 0.5, readModifyWriteProportion = 0.5),
+        ).associateBy { it.name }
+    }
+}
+
+enum class Operation {
+    READ,
+    UPDATE,
+    INSERT,
+    SCAN,
+    READ_MODIFY_WRITE
+}
@@ -1,5 +1,7 @@
 package com.edwardstock.leveldb
 
+import java.nio.ByteBuffer
+
 /*
  * Stojan Dimitrovski
  *
@@ -85,4 +87,61 @@ object Bytes {
         }
         return 0
     }
-}
\ No newline at end of file
+
+    /**
+     * Encodes a long key the way the primitive methods of
+     * [com.edwardstock.leveldb.implementation.NativeLevelDB] (`putLong` and so on) store it: 8 bytes big-endian
+     * with the sign bit flipped, so that long keys sort numerically.
+     */
+    @JvmStatic
+    fun fromLongKey(key: Long): ByteArray {
+        return fromLong(key xor Long.MIN_VALUE)
+    }
+
+    /**
+     * Decodes a key encoded by [fromLongKey].
+     */
+    @JvmStatic
+    fun toLongKey(key: ByteArray): Long {
+        require(key.size == 8) { "Key is not a long key, its size is not 8 bytes" }
+        return ByteBuffer.wrap(key).long xor Long.MIN_VALUE
+    }
+
+    /**
+     * Encodes a value the way `NativeLevelDB.putLong` stores it: 8 bytes big-endian.
+     */
+    @JvmStatic
+    fun fromLong(value: Long): ByteArray {
+        return ByteBuffer.allocate(8).putLong(value).array()
+    }
+
+    /**
+     * Decodes a value stored by `NativeLevelDB.putLong`, or by
+     * [com.edwardstock.leveldb.implementation.LongConverter], which stores 1 to 8 bytes big-endian, sign-extended.
+     */
+    @JvmStatic
+    fun toLong(value: ByteArray): Long {
+        require(value.size in 1..8) { "Value is not a primitive, its size is not 1 to 8 bytes" }
+        var decoded = if (value[0] < 0) -1L else 0L
+        for (b in value) {
+            decoded = (decoded shl 8) or (b.toLong() and 0xff)
+        }
+        return decoded
+    }
+
+    /**
+     * Encodes a value the way `NativeLevelDB.putDouble` stores it: IEEE 754 bits, 8 bytes big-endian.
+     */
+    @JvmStatic
+    fun fromDouble(value: Double): ByteArray {
+        return fromLong(value.toRawBits())
+    }
+
+    /**
+     * Decodes a value stored by `NativeLevelDB.putDouble`.
+     */
+    @JvmStatic
+    fun toDouble(value: ByteArray): Double {
+        return Double.fromBits(toLong(value))
+    }
+}
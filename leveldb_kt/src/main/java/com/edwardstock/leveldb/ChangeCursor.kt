@@ -0,0 +1,28 @@
+package com.edwardstock.leveldb
+
+import com.edwardstock.leveldb.exception.LevelDBChangeFeedTruncatedException
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+
+/**
+ * Reads the change feed of a database in write order, in batches.
+ *
+ * A cursor is cheap and holds no native resources: it only remembers the sequence of the last
+ * record it has returned. It's not thread safe.
+ */
+abstract class ChangeCursor(position: Long) {
+    /**
+     * Sequence of the last record returned by this cursor, or the one the cursor started after.
+     */
+    var position: Long = position
+        protected set
+
+    /**
+     * Returns up to [maxRecords] records following [position] and advances the cursor past them.
+     * Returns an empty list if there are no new records yet.
+     * @throws LevelDBChangeFeedTruncatedException if the following records have already been evicted
+     * from the feed. The cursor is left as is; the consumer has to resynchronize, e.g. from a checkpoint.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBChangeFeedTruncatedException::class, LevelDBClosedException::class)
+    abstract fun next(maxRecords: Int = 1024): List<ChangeEvent>
+}
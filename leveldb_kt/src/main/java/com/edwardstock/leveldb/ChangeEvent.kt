@@ -0,0 +1,21 @@
+package com.edwardstock.leveldb
+
+/**
+ * Single record of the change feed.
+ * @property sequence sequence of the write, increasing by one for every record
+ * @property key written key
+ * @property value new value, or null if the key was deleted
+ */
+class ChangeEvent(
+    val sequence: Long,
+    val key: ByteArray,
+    val value: ByteArray?
+) {
+    val isDelete: Boolean
+        get() = value == null
+
+    override fun toString(): String {
+        return "ChangeEvent(sequence=$sequence, key=${key.size} bytes, " +
+                (if (value == null) "delete)" else "value=${value.size} bytes)")
+    }
+}
@@ -0,0 +1,44 @@
+package com.edwardstock.leveldb
+
+/**
+ * Declares which part of a record is the key of a secondary index.
+ *
+ * Extraction runs natively, inside the same write that stores the record, so an index never needs
+ * a callback into the JVM. Records the extractor doesn't cover (e.g. too short value) are simply not indexed.
+ *
+ * @see com.edwardstock.leveldb.implementation.NativeLevelDB.registerIndex
+ */
+sealed class IndexExtractor(
+    internal val type: Int,
+    internal val offset: Int,
+    internal val length: Int,
+    internal val delimiter: Byte
+) {
+    /**
+     * Bytes of the value starting at [offset]. Negative [length] means "up to the end of the value".
+     */
+    class ValueRange(offset: Int, length: Int = -1) : IndexExtractor(VALUE_RANGE, offset, length, 0)
+
+    /**
+     * [field]-th (zero-based) field of the value, where fields are separated by [delimiter].
+     */
+    class ValueField(delimiter: Char, field: Int) : IndexExtractor(VALUE_FIELD, field, -1, delimiter.code.toByte())
+
+    /**
+     * Bytes of the key starting at [offset]. Negative [length] means "up to the end of the key".
+     */
+    class KeyRange(offset: Int, length: Int = -1) : IndexExtractor(KEY_RANGE, offset, length, 0)
+
+    /**
+     * [field]-th (zero-based) field of the key, where fields are separated by [delimiter].
+     */
+    class KeyField(delimiter: Char, field: Int) : IndexExtractor(KEY_FIELD, field, -1, delimiter.code.toByte())
+
+    internal companion object {
+        // Must match IndexSpec::Type in secondary_index.h
+        const val VALUE_RANGE = 0
+        const val VALUE_FIELD = 1
+        const val KEY_RANGE = 2
+        const val KEY_FIELD = 3
+    }
+}
@@ -0,0 +1,16 @@
+package com.edwardstock.leveldb
+
+/**
+ * Counters of the native iterator pool since the database was opened.
+ * @property hits iterators and scans that reused an idle iterator
+ * @property misses iterators and scans that had to create one
+ * @property idle iterators kept for reuse right now, none after a write
+ */
+data class IteratorPoolStats(
+    val hits: Long,
+    val misses: Long,
+    val idle: Long = 0
+) {
+    val hitRate: Double
+        get() = if (hits + misses == 0L) 0.0 else hits.toDouble() / (hits + misses)
+}
@@ -51,6 +51,7 @@ abstract class LevelDB(
     companion object {
         const val DEFAULT_DBNAME = "default.ldb"
         const val NATIVE_LIB_NAME = "leveldb_jni"
+        const val IN_MEMORY_PATH = ":memory:"
 
         @JvmStatic
         fun loadNative() {
@@ -73,6 +74,29 @@ abstract class LevelDB(
             return NativeLevelDB(path, config)
         }
 
+        /**
+         * Opens a new native database that keeps all of its files in memory, with the same semantics as an
+         * on-disk one: snapshots, ordered iteration, transactions and so on. It's gone once closed.
+         *
+         * Use [Config.memoryLimit] to cap its size and
+         * [com.edwardstock.leveldb.implementation.NativeLevelDB.checkpoint] to dump it to disk.
+         * @param config configuration, [Config.createIfMissing] and [Config.readaheadSize] are ignored
+         * @param loadFrom path of an on-disk database to start with a copy of. It must not be open
+         * @return a new [com.edwardstock.leveldb.implementation.NativeLevelDB] instance
+         * @throws LevelDBException
+         */
+        @JvmStatic
+        @JvmOverloads
+        @Throws(LevelDBException::class)
+        fun openInMemory(config: Config = Config(), loadFrom: String? = null): LevelDB {
+            return NativeLevelDB(IN_MEMORY_PATH, config, true, loadFrom)
+        }
+
+        @Throws(LevelDBException::class)
+        fun openInMemory(loadFrom: String? = null, config: Config.() -> Unit): LevelDB {
+            return openInMemory(Config().apply(config), loadFrom)
+        }
+
         /**
          * Creates a new [com.edwardstock.leveldb.implementation.mock.MockLevelDB] useful in
          * testing in non-Android environments such as Robolectric. It does not access the filesystem,
@@ -109,6 +133,39 @@ abstract class LevelDB(
         fun repair(path: String) {
             NativeLevelDB.repair(path)
         }
+
+        /**
+         * Limits the native memory of all databases open in this process, see [MemoryUsage]. Writes check the
+         * budget every few hundred kilobytes written; over it, the block and row caches of all databases are
+         * pruned and, if that's not enough, the largest memtables are flushed to disk early. That runs on a
+         * background thread, one check at a time, and writes never wait for it.
+         *
+         * Blocks in use and the files of in-memory databases are never freed, so the usage may stay above
+         * the budget.
+         * @param bytes the budget, 0 for none, which is the default
+         */
+        @JvmStatic
+        fun setMemoryBudget(bytes: Long) {
+            require(bytes >= 0) { "Memory budget must not be negative." }
+            NativeLevelDB.setMemoryBudget(bytes)
+        }
+
+        /**
+         * The process-wide memory budget and the usage of all open native databases.
+         */
+        @JvmStatic
+        fun memoryBudget(): MemoryBudget {
+            return NativeLevelDB.memoryBudget()
+        }
+
+        /**
+         * Prunes the block and row caches of all open native databases, whatever the budget, e.g. from
+         * `ComponentCallbacks2.onTrimMemory`.
+         */
+        @JvmStatic
+        fun trimMemory() {
+            NativeLevelDB.trimMemory()
+        }
     }
 
     /**
@@ -394,6 +451,44 @@ abstract class LevelDB(
     }
 
 
+    /**
+     * Reads up to [n] records in key order, starting at [start], or right after it, and ending before [limit].
+     * Meant for short range reads, where it spares the caller setting up and closing an iterator; native
+     * databases read all records in a single call and reuse their iterators.
+     * @param start first key, null for the first key of the database
+     * @param limit key to stop at, exclusive, null for the end of the database
+     * @param n maximum number of records to read
+     * @param snapshot the snapshot from which to read the records, may be null
+     * @return the records, at most [n]
+     * @throws LevelDBSnapshotOwnershipException
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
+    open fun scan(start: ByteArray?, limit: ByteArray?, n: Int, snapshot: Snapshot? = null): List<Record> {
+        require(n >= 0) { "Record count must not be negative." }
+        val records = ArrayList<Record>()
+        if (n == 0) {
+            return records
+        }
+
+        iterator(true, snapshot).use { iterator ->
+            if (start != null) {
+                iterator.seek(start)
+            } else {
+                iterator.seekToFirst()
+            }
+            while (records.size < n && iterator.isValid) {
+                val key = iterator.key()
+                if (limit != null && ByteOrder.compare(key, limit) >= 0) {
+                    break
+                }
+                records.add(Record(key, iterator.value()))
+                iterator.next()
+            }
+        }
+        return records
+    }
+
     /**
      * The path of this LevelDB. Usually a filesystem path, but may be something else
      * (eg: [com.edwardstock.leveldb.implementation.mock.MockLevelDB.getPath].
@@ -437,7 +532,7 @@ abstract class LevelDB(
      * Specifies a configuration to open the database with.
      *
      * @param createIfMissing If true, the database will be created if it is missing.
-     * @param cacheSize Maximum cache size for fillCache parameter
+     * @param cacheSize Maximum cache size for fillCache parameter, 0 for leveldb's default of 8 MB
      * @param blockSize Approximate size of user data packed per block.
      * Note that the block size specified here corresponds to uncompressed data.
      * The actual size of the unit read from disk may be smaller if
@@ -453,6 +548,39 @@ abstract class LevelDB(
      * the next time the database is opened.
      *
      * @param adapters data mapper for user types
+     * @param changeFeedBufferSize Size in bytes of the in-memory change feed, 0 disables it.
+     * See [com.edwardstock.leveldb.implementation.NativeLevelDB.changes].
+     * @param rowCacheSize Size in bytes of the native cache of whole records in front of `get`, 0 disables it.
+     * Best for small hot records read at high rates, see
+     * [com.edwardstock.leveldb.implementation.NativeLevelDB.rowCacheStats].
+     * @param readaheadSize Size in bytes of the readahead window of scans, 0 keeps leveldb's default file access.
+     *
+     * When set, table files are read with `pread` instead of being memory-mapped. Iterators created
+     * with `fillCache = false` and compactions then read tables in windows of this size, with
+     * `posix_fadvise` sequential and will-need hints, so cold scans run at sequential disk throughput.
+     * Every open iterator and running compaction keeps a window for each of up to 8 tables it reads,
+     * freed when it closes or finishes, and counted in
+     * [MemoryUsage.iterators][com.edwardstock.leveldb.MemoryUsage.iterators]. 1-4 MB are sensible values.
+     * @param throttleWrites Whether to delay writes slightly while level-0 fills up, before leveldb has to
+     * slow down or stop writers. The delay starts at 0.1 ms with 4 level-0 files and doubles with every
+     * further file. See [com.edwardstock.leveldb.implementation.NativeLevelDB.writePressure].
+     * @param memoryLimit Only for [in-memory][LevelDB.openInMemory] databases: maximum size in bytes of their
+     * files, 0 means no limit. Writes that would exceed it fail with
+     * [com.edwardstock.leveldb.exception.LevelDBIOException]. Compactions may take the files over the limit
+     * for a while, as they rewrite data before dropping the old copy.
+     * @param snapshotMaxAge Snapshots open for longer than this many milliseconds are released automatically,
+     * 0 keeps them until released. Reads from an expired snapshot fail with
+     * [com.edwardstock.leveldb.exception.LevelDBClosedException], iterators already created from it keep working.
+     * See [com.edwardstock.leveldb.implementation.NativeLevelDB.snapshotStats].
+     * @param snapshotLeakDetection Whether to record the stack trace of every [LevelDB.obtainSnapshot] call,
+     * so that [snapshotLeakListener] can tell where a leaked snapshot comes from. Costs a stack walk per
+     * snapshot, meant for debug builds.
+     * @param snapshotLeakListener Called with every snapshot that expires by [snapshotMaxAge] or is still open
+     * when the database is closed. Runs on the expiring or closing thread.
+     * @param eventListener Called with flushes, compactions and write stalls of the database as they start and
+     * end, on a dedicated thread. A slow listener doesn't hold up the database: events that don't fit into
+     * [eventQueueSize] are dropped and reported as [LevelDBEvent.EventsDropped].
+     * @param eventQueueSize Number of events queued natively for [eventListener].
      */
     data class Config(
         var createIfMissing: Boolean = true,
@@ -474,7 +602,17 @@ abstract class LevelDB(
             Long::class to LongConverter(),
             ULong::class to ULongConverter(),
             BigInteger::class to BigIntegerConverter(),
-        )
+        ),
+        var changeFeedBufferSize: Int = 0,
+        var rowCacheSize: Int = 0,
+        var readaheadSize: Int = 0,
+        var throttleWrites: Boolean = false,
+        var memoryLimit: Long = 0,
+        var snapshotMaxAge: Long = 0,
+        var snapshotLeakDetection: Boolean = false,
+        var snapshotLeakListener: ((SnapshotLeak) -> Unit)? = null,
+        var eventListener: ((LevelDBEvent) -> Unit)? = null,
+        var eventQueueSize: Int = 1024
     ) {
 
         @Suppress("UNCHECKED_CAST")
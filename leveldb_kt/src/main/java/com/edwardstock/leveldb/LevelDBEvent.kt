@@ -0,0 +1,73 @@
+package com.edwardstock.leveldb
+
+/**
+ * Background event of a database, delivered to [LevelDB.Config.eventListener].
+ * Durations are measured natively, from the start to the end of the work.
+ */
+sealed class LevelDBEvent {
+
+    /**
+     * The memtable started being written to the level-0 table [tableNumber].
+     */
+    data class FlushStarted(val tableNumber: Long) : LevelDBEvent()
+
+    /**
+     * The memtable has been written to the level-0 table [tableNumber] of [bytes] bytes.
+     * @property succeeded false if writing the table failed, the error is then a background error of the database
+     */
+    data class FlushCompleted(
+        val tableNumber: Long,
+        val bytes: Long,
+        val durationMicros: Long,
+        val succeeded: Boolean
+    ) : LevelDBEvent()
+
+    /**
+     * A compaction of [inputFiles] files at [level] into [outputLevelFiles] overlapping files at [level] + 1 started.
+     */
+    data class CompactionStarted(
+        val level: Int,
+        val inputFiles: Int,
+        val outputLevelFiles: Int
+    ) : LevelDBEvent()
+
+    /**
+     * A compaction from [level] into [level] + 1 is done.
+     * @property bytesRead bytes read from the input tables
+     * @property bytesWritten bytes of the resulting tables, 0 if the compaction failed
+     */
+    data class CompactionCompleted(
+        val level: Int,
+        val bytesRead: Long,
+        val bytesWritten: Long,
+        val durationMicros: Long,
+        val succeeded: Boolean
+    ) : LevelDBEvent()
+
+    /**
+     * A write started waiting for leveldb, see [WritePressure].
+     */
+    data class WriteStallStarted(val reason: StallReason) : LevelDBEvent()
+
+    /**
+     * A write that had to wait for leveldb went through after [durationMicros].
+     */
+    data class WriteStallEnded(val durationMicros: Long) : LevelDBEvent()
+
+    /**
+     * [count] events were dropped because the listener didn't keep up, see [LevelDB.Config.eventQueueSize].
+     */
+    data class EventsDropped(val count: Long) : LevelDBEvent()
+
+    enum class StallReason {
+        /**
+         * The memtable is full and the previous one is still being flushed.
+         */
+        MEMTABLE_FULL,
+
+        /**
+         * There are too many level-0 tables, writes wait for a compaction.
+         */
+        TOO_MANY_L0_FILES
+    }
+}
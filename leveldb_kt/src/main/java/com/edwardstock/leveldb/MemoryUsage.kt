@@ -0,0 +1,39 @@
+package com.edwardstock.leveldb
+
+/**
+ * Native memory a database takes right now, in bytes, by component.
+ * @property memtables the memtable being written and the one being flushed, up to twice
+ * [LevelDB.Config.writeBufferSize]
+ * @property blockCache blocks in the block cache, up to [LevelDB.Config.cacheSize], including the blocks iterators
+ * are positioned in
+ * @property rowCache records in the row cache, up to [LevelDB.Config.rowCacheSize]
+ * @property tableIndexes index blocks of the open tables, which leveldb keeps in memory
+ * @property iterators estimate of the blocks held by open iterators that don't fill the block cache, plus the
+ * [readahead windows][LevelDB.Config.readaheadSize] of iterators and compactions
+ * @property files files of an in-memory database
+ */
+data class MemoryUsage(
+    val memtables: Long,
+    val blockCache: Long,
+    val rowCache: Long,
+    val tableIndexes: Long,
+    val iterators: Long,
+    val files: Long
+) {
+    val total: Long
+        get() = memtables + blockCache + rowCache + tableIndexes + iterators + files
+}
+
+/**
+ * State of the process-wide memory budget, see [LevelDB.setMemoryBudget].
+ * @property limit the budget in bytes, 0 if there is none
+ * @property usage [MemoryUsage.total] of all open native databases
+ * @property enforcements how often writes have found the budget exceeded
+ * @property flushes memtables flushed early to get back under the budget
+ */
+data class MemoryBudget(
+    val limit: Long,
+    val usage: Long,
+    val enforcements: Long,
+    val flushes: Long
+)
@@ -0,0 +1,13 @@
+package com.edwardstock.leveldb
+
+/**
+ * A record read by [LevelDB.scan].
+ */
+class Record(
+    val key: ByteArray,
+    val value: ByteArray
+) {
+    override fun toString(): String {
+        return "Record(key=${key.size} bytes, value=${value.size} bytes)"
+    }
+}
@@ -0,0 +1,18 @@
+package com.edwardstock.leveldb
+
+/**
+ * Counters of the row cache since the database was opened.
+ * @property hits reads served from the cache, including cached misses
+ * @property misses reads that went to the database
+ * @property usage bytes held by the cache
+ * @property capacity size of the cache in bytes
+ */
+data class RowCacheStats(
+    val hits: Long,
+    val misses: Long,
+    val usage: Long,
+    val capacity: Long
+) {
+    val hitRate: Double
+        get() = if (hits + misses == 0L) 0.0 else hits.toDouble() / (hits + misses)
+}
@@ -0,0 +1,110 @@
+package com.edwardstock.leveldb
+
+/**
+ * Decides which shard of a [com.edwardstock.leveldb.implementation.ShardedLevelDB] holds a key.
+ * Routing must stay the same for the lifetime of the data: reopen a sharded database with the router it
+ * was written with.
+ */
+interface ShardRouter {
+    /**
+     * Number of shards, at least 1.
+     */
+    val shards: Int
+
+    /**
+     * Shard of [key], in `[0, shards)`.
+     */
+    fun shardOf(key: ByteArray): Int
+
+    companion object {
+        /**
+         * Spreads keys evenly over [shards] shards by their hash, best for writes. Ordered iteration merges
+         * all shards.
+         */
+        @JvmStatic
+        fun hash(shards: Int): ShardRouter = HashShardRouter(shards)
+
+        /**
+         * Splits the key space at [splitPoints], which must be sorted: shard 0 holds the keys below the first
+         * split point, shard `i` the keys from split point `i - 1` up to split point `i`. Best for workloads
+         * that read or write ranges of adjacent keys, as long as the split points spread the load.
+         */
+        @JvmStatic
+        fun range(vararg splitPoints: ByteArray): ShardRouter = RangeShardRouter(splitPoints.toList())
+    }
+}
+
+private class HashShardRouter(override val shards: Int) : ShardRouter {
+    init {
+        require(shards > 0) { "At least one shard is required" }
+    }
+
+    override fun shardOf(key: ByteArray): Int {
+        return jumpHash(fnv64(key), shards)
+    }
+
+    private fun fnv64(key: ByteArray): Long {
+        var hash = -0x340d631b7bdddcdbL
+        for (b in key) {
+            hash = hash xor (b.toLong() and 0xff)
+            hash *= 0x100000001b3L
+        }
+        return hash
+    }
+
+    // Lamping and Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm": when shards are added,
+    // only the keys that move to the new shards change their shard.
+    private fun jumpHash(key: Long, buckets: Int): Int {
+        var k = key
+        var b = -1L
+        var j = 0L
+        while (j < buckets) {
+            b = j
+            k = k * 2862933555777941757L + 1
+            j = ((b + 1) * ((1L shl 31).toDouble() / ((k ushr 33) + 1).toDouble())).toLong()
+        }
+        return b.toInt()
+    }
+}
+
+private class RangeShardRouter(private val splitPoints: List<ByteArray>) : ShardRouter {
+    override val shards: Int = splitPoints.size + 1
+
+    init {
+        for (i in 1 until splitPoints.size) {
+            require(ByteOrder.compare(splitPoints[i - 1], splitPoints[i]) < 0) { "Split points must be sorted" }
+        }
+    }
+
+    override fun shardOf(key: ByteArray): Int {
+        // Number of split points <= key.
+        var low = 0
+        var high = splitPoints.size
+        while (low < high) {
+            val middle = (low + high) ushr 1
+            if (ByteOrder.compare(splitPoints[middle], key) <= 0) {
+                low = middle + 1
+            } else {
+                high = middle
+            }
+        }
+        return low
+    }
+}
+
+/**
+ * Order of keys in a native database: bytewise, unsigned, a prefix first. Unlike [Bytes.lexicographicCompare],
+ * trailing zero bytes count.
+ */
+internal object ByteOrder {
+    fun compare(a: ByteArray, b: ByteArray): Int {
+        val length = minOf(a.size, b.size)
+        for (i in 0 until length) {
+            val diff = (a[i].toInt() and 0xff) - (b[i].toInt() and 0xff)
+            if (diff != 0) {
+                return diff
+            }
+        }
+        return a.size - b.size
+    }
+}
@@ -0,0 +1,15 @@
+package com.edwardstock.leveldb
+
+/**
+ * A snapshot that has been kept open for too long, see [LevelDB.Config.snapshotLeakListener].
+ * @property ageMillis how long the snapshot has been open
+ * @property expired true if it has been released by [LevelDB.Config.snapshotMaxAge], false if it was
+ * still open when the database was closed
+ * @property origin stack trace of the call that obtained the snapshot, only with
+ * [LevelDB.Config.snapshotLeakDetection] enabled
+ */
+data class SnapshotLeak(
+    val ageMillis: Long,
+    val expired: Boolean,
+    val origin: Throwable?
+)
@@ -0,0 +1,17 @@
+package com.edwardstock.leveldb
+
+/**
+ * Snapshots of a database that are open right now. Every open snapshot keeps compactions from dropping
+ * the versions of records it can see, so a snapshot that is never released makes the database grow.
+ * @property count number of open snapshots
+ * @property oldestSequence [com.edwardstock.leveldb.implementation.NativeLevelDB.lastSequence] when the oldest
+ * open snapshot was taken, 0 if there is none
+ * @property oldestAgeMillis age of the oldest open snapshot, 0 if there is none
+ * @property expired number of snapshots released by [LevelDB.Config.snapshotMaxAge] since the database was opened
+ */
+data class SnapshotStats(
+    val count: Long,
+    val oldestSequence: Long,
+    val oldestAgeMillis: Long,
+    val expired: Long
+)
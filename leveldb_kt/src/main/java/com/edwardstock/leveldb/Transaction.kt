@@ -0,0 +1,82 @@
+package com.edwardstock.leveldb
+
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.exception.LevelDBTransactionConflictException
+import java.io.Closeable
+
+/**
+ * Optimistic read-modify-write transaction.
+ *
+ * Reads see the database as of the moment the transaction began, plus the transaction's own writes.
+ * Writes are buffered until [commit], which applies them atomically, unless any key read by
+ * the transaction has been written by someone else in the meantime.
+ *
+ * Transactions don't lock anything until commit, so non-conflicting transactions run in parallel.
+ * A transaction is not thread safe and must be closed before closing the database.
+ */
+abstract class Transaction : Closeable {
+    /**
+     * Retrieves key as seen by this transaction and remembers it for the commit-time validation.
+     * @return data for the key, or null
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    abstract operator fun get(key: ByteArray): ByteArray?
+
+    @Throws(LevelDBException::class)
+    operator fun get(key: String): ByteArray? {
+        return get(key.toByteArray())
+    }
+
+    /**
+     * Buffers a put. Null value deletes the key.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    abstract fun put(key: ByteArray, value: ByteArray?)
+
+    @Throws(LevelDBClosedException::class)
+    fun put(key: String, value: String) {
+        put(key.toByteArray(), value.toByteArray())
+    }
+
+    /**
+     * Buffers a deletion.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    abstract fun del(key: ByteArray)
+
+    @Throws(LevelDBClosedException::class)
+    fun del(key: String) {
+        del(key.toByteArray())
+    }
+
+    /**
+     * Validates the keys read by this transaction and writes the buffered changes atomically.
+     * The transaction is closed afterwards, whatever the outcome.
+     * @param sync whether this write will be forced to disk
+     * @throws LevelDBTransactionConflictException if a read key has been changed concurrently
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBTransactionConflictException::class, LevelDBException::class)
+    abstract fun commit(sync: Boolean = false)
+
+    /**
+     * Whether this transaction has been committed or rolled back.
+     */
+    abstract val isClosed: Boolean
+
+    /**
+     * Discards the buffered changes. Same as [close].
+     */
+    fun rollback() {
+        close()
+    }
+
+    /**
+     * Discards the buffered changes if the transaction has not been committed.
+     */
+    abstract override fun close()
+}
@@ -0,0 +1,14 @@
+package com.edwardstock.leveldb
+
+/**
+ * Outcome of an export or import, see [com.edwardstock.leveldb.implementation.NativeLevelDB.exportTo].
+ * @property records number of records exported or imported
+ * @property bytes size of the stream in bytes, after compression
+ * @property skipped number of records not imported because their keys are reserved for secondary index entries,
+ * always 0 for exports
+ */
+data class TransferStats(
+    val records: Long,
+    val bytes: Long,
+    val skipped: Long
+)
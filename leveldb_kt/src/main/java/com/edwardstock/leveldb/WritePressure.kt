@@ -0,0 +1,23 @@
+package com.edwardstock.leveldb
+
+/**
+ * Live write-pressure signals of a database. Counters are counted since the database was opened.
+ * @property l0Files number of level-0 table files. leveldb slows writes down from 8 files and
+ * stops them from 12 until a compaction catches up
+ * @property flushInProgress whether a memtable is being written to a level-0 table right now
+ * @property stalledWriters number of writes leveldb is making wait right now: the one that hit the stall and
+ * those queued behind it
+ * @property stalls number of times leveldb has made writes wait for a flush or a compaction
+ * @property stallMicros total time these writes have waited
+ * @property throttledWrites number of writes delayed by the adaptive throttle
+ * @property throttleMicros total delay added by the adaptive throttle
+ */
+data class WritePressure(
+    val l0Files: Int,
+    val flushInProgress: Boolean,
+    val stalledWriters: Int,
+    val stalls: Long,
+    val stallMicros: Long,
+    val throttledWrites: Long,
+    val throttleMicros: Long
+)
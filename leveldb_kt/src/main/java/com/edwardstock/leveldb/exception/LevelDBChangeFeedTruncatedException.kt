@@ -0,0 +1,7 @@
+package com.edwardstock.leveldb.exception
+
+/**
+ * Thrown by a change cursor whose next records have been evicted from the change feed, because
+ * the consumer fell behind by more than the feed size.
+ */
+class LevelDBChangeFeedTruncatedException(detailMessage: String?) : LevelDBException(detailMessage)
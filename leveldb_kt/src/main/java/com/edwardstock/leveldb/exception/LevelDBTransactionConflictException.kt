@@ -0,0 +1,7 @@
+package com.edwardstock.leveldb.exception
+
+/**
+ * Thrown on commit when a key the transaction has read was written by someone else after the
+ * transaction began. Nothing was written, start a new transaction and try again.
+ */
+class LevelDBTransactionConflictException(detailMessage: String?) : LevelDBException(detailMessage)
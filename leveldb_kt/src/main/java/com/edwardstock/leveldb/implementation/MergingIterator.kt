@@ -0,0 +1,162 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.ByteOrder
+import com.edwardstock.leveldb.Iterator
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.exception.LevelDBIteratorNotValidException
+
+/**
+ * Iterates over several iterators as one, in key order, like leveldb's own merging iterator does over
+ * its tables. Keys of the children are cached, so every step reads one key from one child. [onClose] runs
+ * once the children are closed.
+ */
+internal class MergingIterator(
+    private val children: List<Iterator>,
+    private val onClose: (() -> Unit)? = null
+) : Iterator() {
+    private val keys = arrayOfNulls<ByteArray>(children.size)
+    private var current = -1
+    private var forward = true
+
+    override var isClosed = false
+        private set
+
+    override val isValid: Boolean
+        get() {
+            checkIfClosed()
+            return current >= 0
+        }
+
+    override fun seekToFirst() {
+        checkIfClosed()
+        children.forEachIndexed { i, child ->
+            child.seekToFirst()
+            refresh(i)
+        }
+        forward = true
+        findSmallest()
+    }
+
+    override fun seekToLast() {
+        checkIfClosed()
+        children.forEachIndexed { i, child ->
+            child.seekToLast()
+            refresh(i)
+        }
+        forward = false
+        findLargest()
+    }
+
+    override fun seek(key: ByteArray?) {
+        checkIfClosed()
+        children.forEachIndexed { i, child ->
+            child.seek(key)
+            refresh(i)
+        }
+        forward = true
+        findSmallest()
+    }
+
+    override fun next() {
+        val key = currentKey()
+
+        if (!forward) {
+            // Children other than the current one are positioned before the current key, move them past it.
+            children.forEachIndexed { i, child ->
+                if (i != current) {
+                    child.seek(key)
+                    if (child.isValid && ByteOrder.compare(child.key(), key) == 0) {
+                        child.next()
+                    }
+                    refresh(i)
+                }
+            }
+            forward = true
+        }
+
+        children[current].next()
+        refresh(current)
+        findSmallest()
+    }
+
+    override fun previous() {
+        val key = currentKey()
+
+        if (forward) {
+            // Children other than the current one are positioned after the current key, move them before it.
+            children.forEachIndexed { i, child ->
+                if (i != current) {
+                    child.seek(key)
+                    if (child.isValid) {
+                        child.previous()
+                    } else {
+                        child.seekToLast()
+                    }
+                    refresh(i)
+                }
+            }
+            forward = false
+        }
+
+        children[current].previous()
+        refresh(current)
+        findLargest()
+    }
+
+    override fun key(): ByteArray {
+        return currentKey().copyOf()
+    }
+
+    override fun value(): ByteArray {
+        currentKey()
+        return children[current].value()
+    }
+
+    override fun close() {
+        if (isClosed) {
+            return
+        }
+        isClosed = true
+        children.forEach { it.close() }
+        onClose?.invoke()
+    }
+
+    private fun currentKey(): ByteArray {
+        checkIfClosed()
+        if (current < 0) {
+            throw LevelDBIteratorNotValidException()
+        }
+        return keys[current]!!
+    }
+
+    private fun refresh(i: Int) {
+        val child = children[i]
+        keys[i] = if (child.isValid) child.key() else null
+    }
+
+    private fun findSmallest() {
+        current = -1
+        for (i in keys.indices) {
+            val key = keys[i] ?: continue
+            if (current < 0 || ByteOrder.compare(key, keys[current]!!) < 0) {
+                current = i
+            }
+        }
+    }
+
+    private fun findLargest() {
+        current = -1
+        for (i in keys.indices.reversed()) {
+            val key = keys[i] ?: continue
+            if (current < 0 || ByteOrder.compare(key, keys[current]!!) > 0) {
+                current = i
+            }
+        }
+    }
+
+    private fun checkIfClosed() {
+        if (isClosed) {
+            throw LevelDBClosedException("Iterator has been closed.")
+        }
+    }
+}
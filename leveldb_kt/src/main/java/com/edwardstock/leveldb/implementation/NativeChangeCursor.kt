@@ -0,0 +1,19 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.ChangeCursor
+import com.edwardstock.leveldb.ChangeEvent
+
+internal class NativeChangeCursor(
+    private val db: NativeLevelDB,
+    position: Long
+) : ChangeCursor(position) {
+
+    override fun next(maxRecords: Int): List<ChangeEvent> {
+        require(maxRecords > 0) { "maxRecords must be positive" }
+        val events = db.readChanges(position, maxRecords)
+        if (events.isNotEmpty()) {
+            position = events.last().sequence
+        }
+        return events
+    }
+}
@@ -0,0 +1,84 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.LevelDBEvent
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+
+/**
+ * Delivers the events a database queues natively to its listener, on a thread of its own so that neither
+ * leveldb's background thread nor writers ever wait for the listener. The thread ends when the database
+ * is closed.
+ */
+internal class NativeEventDispatcher(
+    private val db: NativeLevelDB,
+    private val listener: (LevelDBEvent) -> Unit
+) {
+    @Volatile
+    private var stopped = false
+
+    private val thread = Thread(::run, "leveldb-events").apply {
+        isDaemon = true
+    }
+
+    fun start() {
+        thread.start()
+    }
+
+    /**
+     * Makes the thread stop after the event it delivers right now, if any. Doesn't wait for it.
+     */
+    fun stop() {
+        stopped = true
+    }
+
+    private fun run() {
+        val buffer = LongArray(BATCH * FIELDS)
+        while (!stopped) {
+            val count = try {
+                db.pollEvents(buffer, POLL_TIMEOUT_MILLIS)
+            } catch (e: LevelDBClosedException) {
+                return
+            }
+
+            for (i in 0 until count) {
+                if (stopped) {
+                    return
+                }
+                val event = decode(buffer, i * FIELDS) ?: continue
+                try {
+                    listener(event)
+                } catch (e: Throwable) {
+                    thread.uncaughtExceptionHandler?.uncaughtException(thread, e)
+                }
+            }
+        }
+    }
+
+    private fun decode(buffer: LongArray, offset: Int): LevelDBEvent? {
+        val level = buffer[offset + 1].toInt()
+        val a = buffer[offset + 2]
+        val b = buffer[offset + 3]
+        val c = buffer[offset + 4]
+        val d = buffer[offset + 5]
+
+        // Must match DBEvent::Type in native/binding/event_queue.h.
+        return when (buffer[offset].toInt()) {
+            0 -> LevelDBEvent.FlushStarted(a)
+            1 -> LevelDBEvent.FlushCompleted(a, b, c, d != 0L)
+            2 -> LevelDBEvent.CompactionStarted(level, a.toInt(), b.toInt())
+            3 -> LevelDBEvent.CompactionCompleted(level, a, b, c, d != 0L)
+            4 -> LevelDBEvent.WriteStallStarted(
+                if (a == 0L) LevelDBEvent.StallReason.MEMTABLE_FULL else LevelDBEvent.StallReason.TOO_MANY_L0_FILES
+            )
+            5 -> LevelDBEvent.WriteStallEnded(a)
+            6 -> LevelDBEvent.EventsDropped(a)
+            else -> null
+        }
+    }
+
+    companion object {
+        // Fields per event, DBEvent::kFields natively.
+        const val FIELDS = 6
+        private const val BATCH = 64
+        private const val POLL_TIMEOUT_MILLIS = 100
+    }
+}
@@ -0,0 +1,107 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import java.util.concurrent.atomic.AtomicLongArray
+import java.util.concurrent.locks.LockSupport
+
+/**
+ * Owner of a native pointer that is used by many threads while another one may close it.
+ *
+ * Every native call runs inside [use], which takes no lock: it only bumps the in-flight counter of
+ * the calling thread's stripe and reads the pointer. [close] clears the pointer, so no new call can start,
+ * waits until the calls in flight are done and only then frees the native object.
+ *
+ * The counter is incremented before the pointer is read, and the pointer is cleared before the counters are read.
+ * With both being volatile, either the call sees the cleared pointer or [close] sees the call.
+ */
+internal class NativeHandle(pointer: Long, private val closedMessage: String) {
+
+    @Volatile
+    private var pointer: Long = pointer
+
+    // One counter per cache line, so threads on different stripes don't share lines.
+    private val inFlight = AtomicLongArray(STRIPES * PADDING)
+
+    val isClosed: Boolean
+        get() = pointer == 0L
+
+    /**
+     * Pointer as of now, 0 if closed. Only for identity checks, never pass it to native code outside [use].
+     */
+    val rawPointer: Long
+        get() = pointer
+
+    /**
+     * Runs [block] with the pointer, which stays valid until [block] returns.
+     * @throws LevelDBClosedException if the handle has been closed
+     */
+    @Throws(LevelDBClosedException::class)
+    inline fun <T> use(block: (Long) -> T): T {
+        val pointer = enter()
+        try {
+            return block(pointer)
+        } finally {
+            exit()
+        }
+    }
+
+    /**
+     * Closes the handle and calls [release] once no call is in flight. Only the first call releases,
+     * later ones return false at once.
+     */
+    fun close(release: (Long) -> Unit): Boolean {
+        val closed: Long
+        synchronized(this) {
+            closed = pointer
+            if (closed == 0L) {
+                return false
+            }
+            pointer = 0L
+        }
+
+        awaitInFlight()
+        release(closed)
+        return true
+    }
+
+    internal fun enter(): Long {
+        val slot = slot()
+        inFlight.incrementAndGet(slot)
+
+        val current = pointer
+        if (current == 0L) {
+            inFlight.decrementAndGet(slot)
+            throw LevelDBClosedException(closedMessage)
+        }
+        return current
+    }
+
+    internal fun exit() {
+        inFlight.decrementAndGet(slot())
+    }
+
+    private fun awaitInFlight() {
+        var spins = 0
+        for (stripe in 0 until STRIPES) {
+            while (inFlight.get(stripe * PADDING) != 0L) {
+                if (++spins < MAX_SPINS) {
+                    Thread.yield()
+                } else {
+                    LockSupport.parkNanos(PARK_NANOS)
+                }
+            }
+        }
+    }
+
+    private companion object {
+        const val STRIPES = 32
+        const val PADDING = 8
+        const val MAX_SPINS = 100
+        const val PARK_NANOS = 100_000L
+
+        // A thread always maps to the same stripe, so enter() and exit() touch the same counter.
+        fun slot(): Int {
+            return (Thread.currentThread().id.toInt() and (STRIPES - 1)) * PADDING
+        }
+    }
+}
@@ -39,17 +39,24 @@ import com.edwardstock.leveldb.exception.LevelDBIteratorNotValidException
  * An iterator is used to iterator over the entries in the database according to the total sort order imposed by the
  * comparator.
  */
-open class NativeIterator(nit: Long) : Iterator() {
+open class NativeIterator internal constructor(
+    nit: Long,
+    private val owner: NativeLevelDB?,
+    // Borrowed from the iterator pool of [owner], and given back on close.
+    private val pooled: Boolean = false
+) : Iterator() {
     // Don't touch this or all hell breaks loose.
-    private var nit: Long
+    private val handle: NativeHandle
 
     /**
      * Protected constructor used in [NativeLevelDB.iterator].
      * @param nit the nat pointer
      */
+    constructor(nit: Long) : this(nit, null)
+
     init {
         require(nit != 0L) { "Native iterator pointer must not be NULL!" }
-        this.nit = nit
+        handle = NativeHandle(nit, "Iterator has been closed.")
     }
 
 
@@ -72,10 +79,7 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @get:Throws(LevelDBClosedException::class)
     override val isValid: Boolean
-        get() {
-            checkIfClosed()
-            return nvalid(nit)
-        }
+        get() = handle.use { nvalid(it) }
 
     /**
      * Seeks to the first key-value pair in the database.
@@ -83,8 +87,7 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBClosedException::class)
     override fun seekToFirst() {
-        checkIfClosed()
-        nseekToFirst(nit)
+        handle.use { nseekToFirst(it) }
     }
 
     /**
@@ -96,8 +99,7 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBClosedException::class)
     override fun seekToLast() {
-        checkIfClosed()
-        nseekToLast(nit)
+        handle.use { nseekToLast(it) }
     }
 
     /**
@@ -107,9 +109,8 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBClosedException::class)
     override fun seek(key: ByteArray?) {
-        checkIfClosed()
         requireNotNull(key) { "Seek key must never be null!" }
-        nseek(nit, key)
+        handle.use { nseek(it, key) }
     }
 
     /**
@@ -121,11 +122,10 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBIteratorNotValidException::class, LevelDBClosedException::class)
     override fun next() {
-        checkIfClosed()
-        if (!isValid) {
-            throw LevelDBIteratorNotValidException()
+        handle.use {
+            checkValid(it)
+            nnext(it)
         }
-        nnext(nit)
     }
 
     /**
@@ -137,11 +137,10 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBIteratorNotValidException::class, LevelDBClosedException::class)
     override fun previous() {
-        checkIfClosed()
-        if (!isValid) {
-            throw LevelDBIteratorNotValidException()
+        handle.use {
+            checkValid(it)
+            nprev(it)
         }
-        nprev(nit)
     }
 
     /**
@@ -154,11 +153,10 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBIteratorNotValidException::class, LevelDBClosedException::class)
     override fun key(): ByteArray {
-        checkIfClosed()
-        if (!isValid) {
-            throw LevelDBIteratorNotValidException()
+        return handle.use {
+            checkValid(it)
+            nkey(it)
         }
-        return nkey(nit)
     }
 
     /**
@@ -171,11 +169,10 @@ open class NativeIterator(nit: Long) : Iterator() {
      */
     @Throws(LevelDBIteratorNotValidException::class, LevelDBClosedException::class)
     override fun value(): ByteArray {
-        checkIfClosed()
-        if (!isValid) {
-            throw LevelDBIteratorNotValidException()
+        return handle.use {
+            checkValid(it)
+            nvalue(it)
         }
-        return nvalue(nit)
     }
 
     /**
@@ -183,31 +180,29 @@ open class NativeIterator(nit: Long) : Iterator() {
      * @return
      */
     override val isClosed: Boolean
-        get() = nit == 0L
+        get() = handle.isClosed
 
     /**
-     * Closes this iterator. It will be almost unusable after.
+     * Closes this iterator. It will be almost unusable after. Waits for the calls other threads
+     * are making on this iterator right now.
      *
      *
-     * Always close the iterator before closing the database.
+     * Always close the iterator before closing the database. Iterators left open are closed by
+     * [NativeLevelDB.close].
      */
     override fun close() {
-        if (!isClosed) {
-            nclose(nit)
+        handle.close { nit ->
+            if (!pooled || owner?.recycle(nit) != true) {
+                nclose(nit)
+            }
         }
-        nit = 0
+        owner?.forget(this)
     }
 
-    /**
-     * Checks if this iterator has been closed.
-     * @throws com.edwardstock.leveldb.exception.LevelDBClosedException
-     */
-    @Throws(LevelDBClosedException::class)
-    private fun checkIfClosed() {
-        if (isClosed) {
-            throw LevelDBClosedException("Iterator has been closed.")
+    @Throws(LevelDBIteratorNotValidException::class)
+    private fun checkValid(nit: Long) {
+        if (!nvalid(nit)) {
+            throw LevelDBIteratorNotValidException()
         }
     }
-
-
-}
\ No newline at end of file
+}
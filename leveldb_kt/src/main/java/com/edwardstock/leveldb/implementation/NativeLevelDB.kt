@@ -1,12 +1,37 @@
 package com.edwardstock.leveldb.implementation
 
+import com.edwardstock.leveldb.ChangeCursor
+import com.edwardstock.leveldb.ChangeEvent
+import com.edwardstock.leveldb.IndexExtractor
+import com.edwardstock.leveldb.IteratorPoolStats
 import com.edwardstock.leveldb.Iterator
 import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.MemoryBudget
+import com.edwardstock.leveldb.MemoryUsage
+import com.edwardstock.leveldb.Record
+import com.edwardstock.leveldb.RowCacheStats
 import com.edwardstock.leveldb.Snapshot
+import com.edwardstock.leveldb.SnapshotLeak
+import com.edwardstock.leveldb.SnapshotStats
+import com.edwardstock.leveldb.Transaction
+import com.edwardstock.leveldb.TransferStats
 import com.edwardstock.leveldb.WriteBatch
+import com.edwardstock.leveldb.WritePressure
+import com.edwardstock.leveldb.exception.LevelDBChangeFeedTruncatedException
 import com.edwardstock.leveldb.exception.LevelDBClosedException
 import com.edwardstock.leveldb.exception.LevelDBException
 import com.edwardstock.leveldb.exception.LevelDBSnapshotOwnershipException
+import com.edwardstock.leveldb.exception.LevelDBTransactionConflictException
+import java.io.File
+import java.io.InputStream
+import java.io.OutputStream
+import java.nio.ByteBuffer
+import java.util.Collections
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.Executors
+import java.util.concurrent.ScheduledExecutorService
+import java.util.concurrent.ScheduledFuture
+import java.util.concurrent.TimeUnit
 import java.util.concurrent.atomic.AtomicLong
 
 /*
@@ -44,27 +69,39 @@ import java.util.concurrent.atomic.AtomicLong
 /**
  * Object for interacting with the native LevelDB implementation.
  */
-class NativeLevelDB(
+class NativeLevelDB internal constructor(
     filePath: String,
-    config: Config
+    config: Config,
+    /**
+     * Whether this database keeps everything in memory, see [LevelDB.openInMemory].
+     */
+    val isInMemory: Boolean,
+    loadFrom: String?
 ) : LevelDB(config) {
 
+    constructor(filePath: String, config: Config) : this(filePath, config, false, null)
+
     /**
      * This is the underlying pointer. If you touch this, all hell breaks loose and everyone dies.
      */
-    private val ref: AtomicLong = AtomicLong(0L)
-    private val refValue: Long
-        get() {
-            assert(ref.get() != 0L) { "Getting null pointer of LevelDB" }
-            return ref.get()
-        }
+    private val handle: NativeHandle
+
+    // Native objects that live on top of this database and must be freed before it.
+    private val iterators: MutableSet<NativeIterator> = Collections.newSetFromMap(ConcurrentHashMap())
+    private val snapshots: MutableSet<NativeSnapshot> = Collections.newSetFromMap(ConcurrentHashMap())
+    private val transactions: MutableSet<NativeTransaction> = Collections.newSetFromMap(ConcurrentHashMap())
+
+    private val expiredSnapshots = AtomicLong()
+    private val snapshotExpiry: ScheduledFuture<*>?
+
+    private val eventDispatcher: NativeEventDispatcher?
 
     /**
      * Checks whether this database has been closed.
      * @return true if closed, false if not
      */
     override val isClosed: Boolean
-        get() = ref.get() == 0L
+        get() = handle.isClosed
 
     /**
      * The path that this database has been opened with.
@@ -74,28 +111,86 @@ class NativeLevelDB(
     override var path: String = filePath
 
     init {
-        ref.set(
+        val listener = config.eventListener
+        val eventQueueSize = if (listener != null) config.eventQueueSize else 0
+        val ndb = if (isInMemory) {
+            nopenInMemory(
+                config.cacheSize,
+                config.blockSize,
+                config.writeBufferSize,
+                config.changeFeedBufferSize,
+                config.rowCacheSize,
+                config.throttleWrites,
+                eventQueueSize,
+                config.memoryLimit,
+                loadFrom,
+                path
+            )
+        } else {
             nopen(
                 config.createIfMissing,
                 config.cacheSize,
                 config.blockSize,
                 config.writeBufferSize,
+                config.changeFeedBufferSize,
+                config.rowCacheSize,
+                config.readaheadSize,
+                config.throttleWrites,
+                eventQueueSize,
                 path
             )
-        )
+        }
+        handle = NativeHandle(ndb, "This database has been closed!")
+
+        snapshotExpiry = if (config.snapshotMaxAge > 0) {
+            val period = (config.snapshotMaxAge / 4).coerceIn(MIN_EXPIRY_PERIOD, MAX_EXPIRY_PERIOD)
+            expiryExecutor.scheduleWithFixedDelay(::expireSnapshots, period, period, TimeUnit.MILLISECONDS)
+        } else {
+            null
+        }
+
+        eventDispatcher = listener?.let { NativeEventDispatcher(this, it) }
+        eventDispatcher?.start()
     }
 
     /**
      * Closes this database, i.e. releases nat resources. You may call this multiple times. You cannot use any other
      * method on this object after closing it.
+     *
+     * Calls other threads are making on this database right now finish first. Iterators, snapshots and
+     * transactions still open are closed as well.
      */
     override fun close() {
-        if (ref.get() != 0L) {
-            nclose(refValue)
-            ref.set(0L)
+        snapshotExpiry?.cancel(false)
+        eventDispatcher?.let { dispatcher ->
+            dispatcher.stop()
+            try {
+                handle.use { nstopEvents(it) }
+            } catch (e: LevelDBClosedException) {
+                // already closed
+            }
+        }
+        handle.close { ndb ->
+            iterators.toList().forEach { it.close() }
+            transactions.toList().forEach { it.close() }
+            snapshots.toList().forEach { snapshot ->
+                if (snapshot.handle.close { nreleaseSnapshot(ndb, it) }) {
+                    reportLeak(snapshot, false)
+                }
+            }
+            snapshots.clear()
+            nclose(ndb)
         }
     }
 
+    internal fun forget(iterator: NativeIterator) {
+        iterators.remove(iterator)
+    }
+
+    internal fun forget(transaction: NativeTransaction) {
+        transactions.remove(transaction)
+    }
+
     /**
      * Writes a key-value record to the database. Wirting can be synchronous or asynchronous.
      *
@@ -113,8 +208,7 @@ class NativeLevelDB(
     @Throws(LevelDBException::class)
     override fun put(key: ByteArray, value: ByteArray?, sync: Boolean) {
         value?.let {
-            checkIfClosed()
-            nput(refValue, sync, key, value)
+            handle.use { nput(it, sync, key, value) }
         } ?: del(key, sync)
     }
 
@@ -126,9 +220,10 @@ class NativeLevelDB(
      */
     @Throws(LevelDBException::class)
     override fun write(writeBatch: WriteBatch, sync: Boolean) {
-        checkIfClosed()
-        NativeWriteBatch(writeBatch).use { batch ->
-            nwrite(refValue, sync, batch.nativePointer())
+        handle.use { ndb ->
+            NativeWriteBatch(writeBatch).use { batch ->
+                nwrite(ndb, sync, batch.nativePointer())
+            }
         }
     }
 
@@ -141,16 +236,9 @@ class NativeLevelDB(
      */
     @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
     override fun get(key: ByteArray, snapshot: Snapshot?): ByteArray? {
-        if (snapshot != null) {
-            if (snapshot !is NativeSnapshot) {
-                throw LevelDBSnapshotOwnershipException()
-            }
-            if (!snapshot.checkOwner(this)) {
-                throw LevelDBSnapshotOwnershipException()
-            }
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { nget(ndb, key, it) }
         }
-        checkIfClosed()
-        return nget(refValue, key, if (snapshot == null) 0 else (snapshot as NativeSnapshot).id())
     }
 
     /**
@@ -161,8 +249,134 @@ class NativeLevelDB(
      */
     @Throws(LevelDBException::class)
     override fun del(key: ByteArray, sync: Boolean) {
-        checkIfClosed()
-        ndelete(refValue, sync, key)
+        handle.use { ndelete(it, sync, key) }
+    }
+
+    /**
+     * Writes a long without allocating: the value is stored as 8 bytes big-endian, encoded natively.
+     * Long keys are stored the same way with the sign bit flipped, so they iterate in numeric order,
+     * see [com.edwardstock.leveldb.Bytes.fromLongKey].
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun putLong(key: Long, value: Long, sync: Boolean = false) {
+        handle.use { nputLong(it, sync, null, key, value) }
+    }
+
+    /**
+     * @see putLong
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun putLong(key: ByteArray, value: Long, sync: Boolean = false) {
+        handle.use { nputLong(it, sync, key, 0, value) }
+    }
+
+    /**
+     * Writes a double without allocating: the value is stored as its IEEE 754 bits, 8 bytes big-endian.
+     * @see putLong
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun putDouble(key: Long, value: Double, sync: Boolean = false) {
+        handle.use { nputDouble(it, sync, null, key, value) }
+    }
+
+    /**
+     * @see putDouble
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun putDouble(key: ByteArray, value: Double, sync: Boolean = false) {
+        handle.use { nputDouble(it, sync, key, 0, value) }
+    }
+
+    /**
+     * Reads a long written by [putLong] or [incrementLong] without allocating. Values written through
+     * [LongConverter], 1 to 8 bytes big-endian, are read as well.
+     * @return the value, or [defaultValue] if there is no record
+     * @throws LevelDBException if the record is empty or longer than 8 bytes
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    @JvmOverloads
+    fun getLong(key: Long, defaultValue: Long = 0, snapshot: Snapshot? = null): Long {
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { ngetLong(ndb, null, key, defaultValue, it) }
+        }
+    }
+
+    /**
+     * @see getLong
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    @JvmOverloads
+    fun getLong(key: ByteArray, defaultValue: Long = 0, snapshot: Snapshot? = null): Long {
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { ngetLong(ndb, key, 0, defaultValue, it) }
+        }
+    }
+
+    /**
+     * Reads a double written by [putDouble] without allocating.
+     * @return the value, or [defaultValue] if there is no record
+     * @throws LevelDBException if the record is empty or longer than 8 bytes
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    @JvmOverloads
+    fun getDouble(key: Long, defaultValue: Double = 0.0, snapshot: Snapshot? = null): Double {
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { ngetDouble(ndb, null, key, defaultValue, it) }
+        }
+    }
+
+    /**
+     * @see getDouble
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    @JvmOverloads
+    fun getDouble(key: ByteArray, defaultValue: Double = 0.0, snapshot: Snapshot? = null): Double {
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { ngetDouble(ndb, key, 0, defaultValue, it) }
+        }
+    }
+
+    /**
+     * Reads the longs of many long keys in one native call. Reuse [values] across calls to read without
+     * allocating. Each key is read on its own, pass a [snapshot] to read them all from the same state.
+     * @param values receives the value of `keys[i]` at `values[i]`, or [defaultValue] if there is no record
+     * @return number of keys found
+     * @throws LevelDBException if a record is empty or longer than 8 bytes
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    @JvmOverloads
+    fun getLongs(keys: LongArray, values: LongArray, defaultValue: Long = 0, snapshot: Snapshot? = null): Int {
+        require(values.size >= keys.size) { "values must be at least as long as keys" }
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { ngetLongs(ndb, keys, values, defaultValue, it) }
+        }
+    }
+
+    /**
+     * Atomically adds [delta] to the long stored under [key], a missing record counts as 0. Concurrent
+     * increments of the same key never get lost. Overflow wraps around.
+     * @return the new value
+     * @throws LevelDBException if the record is empty or longer than 8 bytes
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun incrementLong(key: Long, delta: Long = 1, sync: Boolean = false): Long {
+        return handle.use { nincrementLong(it, sync, null, key, delta) }
+    }
+
+    /**
+     * @see incrementLong
+     */
+    @Throws(LevelDBException::class)
+    @JvmOverloads
+    fun incrementLong(key: ByteArray, delta: Long = 1, sync: Boolean = false): Long {
+        return handle.use { nincrementLong(it, sync, key, 0, delta) }
     }
 
     /**
@@ -187,43 +401,98 @@ class NativeLevelDB(
      */
     @Throws(LevelDBClosedException::class)
     override fun getPropertyBytes(key: ByteArray): ByteArray? {
-        checkIfClosed()
-        return ngetProperty(refValue, key)
+        return handle.use { ngetProperty(it, key) }
     }
 
     /**
      * Creates a new [com.edwardstock.leveldb.Iterator] that iterates over this database.
      *
      *
-     * The returned iterator is not thread safe and must be closed with [com.edwardstock.leveldb.Iterator.close] before closing this
-     * database.
+     * The returned iterator is not thread safe and should be closed with [com.edwardstock.leveldb.Iterator.close] when done.
+     * Iterators still open are closed along with this database.
      * @param fillCache whether iterating fills the internal cache
      * @return a new iterator
      * @throws LevelDBClosedException
      */
     @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
     override fun iterator(fillCache: Boolean, snapshot: Snapshot?): Iterator {
-        if (snapshot != null) {
-            if (snapshot !is NativeSnapshot) {
-                throw LevelDBSnapshotOwnershipException()
-            }
-            if (snapshot.checkOwner(this)) {
-                throw LevelDBSnapshotOwnershipException()
+        return handle.use { ndb ->
+            // Only these can be reused, see iteratorPoolStats().
+            val pooled = fillCache && snapshot == null
+            val iterator = if (pooled) {
+                NativeIterator(nacquireIterator(ndb), this, true)
+            } else {
+                NativeIterator(withSnapshot(snapshot) { niterate(ndb, fillCache, it) }, this)
             }
+            iterators.add(iterator)
+            iterator
         }
-        checkIfClosed()
-        return NativeIterator(
-            niterate(
-                refValue,
-                fillCache,
-                if (snapshot == null) 0 else (snapshot as NativeSnapshot).id()
-            )
-        )
+    }
+
+    /**
+     * Gives a pooled iterator back to the native pool.
+     * @return false if the database is closing, the iterator must be deleted then
+     */
+    internal fun recycle(nit: Long): Boolean {
+        return try {
+            handle.use { nreleaseIterator(it, nit) }
+            true
+        } catch (e: LevelDBClosedException) {
+            false
+        }
+    }
+
+    /**
+     * Reads up to [n] records in one native call, with a pooled iterator if [snapshot] is null.
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
+    override fun scan(start: ByteArray?, limit: ByteArray?, n: Int, snapshot: Snapshot?): List<Record> {
+        require(n >= 0) { "Record count must not be negative." }
+        if (n == 0) {
+            return emptyList()
+        }
+
+        val buffer = ByteBuffer.wrap(handle.use { ndb ->
+            withSnapshot(snapshot) { nscan(ndb, start, limit, n, it) }
+        })
+        val records = ArrayList<Record>()
+        while (buffer.hasRemaining()) {
+            val key = ByteArray(buffer.int).also { buffer.get(it) }
+            val value = ByteArray(buffer.int).also { buffer.get(it) }
+            records.add(Record(key, value))
+        }
+        return records
+    }
+
+    /**
+     * Counters of the native iterator pool since the database was opened.
+     *
+     * Iterators without a snapshot that fill the cache, and [scan]s without a snapshot, reuse the idle iterators
+     * of the pool. leveldb iterators can't be moved to a later state of the database, so an idle iterator is
+     * reused only until the next write, which pays off for databases mostly read.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun iteratorPoolStats(): IteratorPoolStats {
+        val stats = handle.use { niteratorPoolStats(it) }
+        return IteratorPoolStats(hits = stats[0], misses = stats[1], idle = stats[2])
+    }
+
+    /**
+     * Bytes read from disk by the tables of a database opened with a `readaheadSize`.
+     */
+    @Throws(LevelDBClosedException::class)
+    internal fun readaheadBytesRead(): Long {
+        return handle.use { nreadaheadBytesRead(it) }
     }
 
     @Throws(LevelDBClosedException::class)
     override fun obtainSnapshot(): Snapshot {
-        return NativeSnapshot(this, nsnapshot(refValue))
+        return handle.use { ndb ->
+            val snapshot = NativeSnapshot(this, nsnapshot(ndb))
+            snapshots.add(snapshot)
+            snapshot
+        }
     }
 
     @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
@@ -235,18 +504,474 @@ class NativeLevelDB(
         if (!snapshot.checkOwner(this)) {
             throw LevelDBSnapshotOwnershipException()
         }
-        checkIfClosed()
-        nreleaseSnapshot(refValue, snapshot.release())
+        handle.use { ndb ->
+            snapshot.handle.close { nreleaseSnapshot(ndb, it) }
+            snapshots.remove(snapshot)
+        }
     }
 
     /**
-     * Checks if this database has been closed. If it has, throws a [com.edwardstock.leveldb.exception.LevelDBClosedException].
+     * Registers a secondary index. From now on every put, delete and [WriteBatch] written to this database
+     * updates the index entries in the same atomic write as the records themselves.
+     *
+     * Registrations are not persisted: register your indexes every time the database is opened. Records written
+     * before the registration (or while the index was not registered) are indexed only after [rebuildIndex]. Until
+     * then lookups skip the entries of records that changed in the meantime. Re-registering a name with a different
+     * extractor deletes the entries of the old one.
+     *
+     * Index entries are stored in this database under keys starting with two zero bytes followed by `idx`. Iterators,
+     * [scan] and [exportTo] skip them, and writes of such keys fail with a [LevelDBException], whether or not an
+     * index is registered.
+     * @param name unique index name
+     * @param extractor which part of the record is the index key
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun registerIndex(name: String, extractor: IndexExtractor) {
+        handle.use {
+            nregisterIndex(
+                it,
+                name,
+                extractor.type,
+                extractor.offset,
+                extractor.length,
+                extractor.delimiter
+            )
+        }
+    }
+
+    /**
+     * Unregisters a secondary index.
+     * @param name index name
+     * @param purge whether to delete all entries of the index as well
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun dropIndex(name: String, purge: Boolean = true) {
+        handle.use { ndropIndex(it, name, purge) }
+    }
+
+    /**
+     * Finds the records whose index key equals [indexKey] in a single native call.
+     * @param name registered index name
+     * @param indexKey index key to look for
+     * @param limit maximum number of records, 0 means no limit
+     * @param snapshot the snapshot from which to read the records, may be null
+     * @return values of the matching records, ordered by their keys
+     * @throws LevelDBException if the index is not registered
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun lookupByIndex(
+        name: String,
+        indexKey: ByteArray,
+        limit: Int = 0,
+        snapshot: Snapshot? = null
+    ): List<ByteArray> {
+        return handle.use { ndb ->
+            withSnapshot(snapshot) { nlookupByIndex(ndb, name, indexKey, limit, it) }.asList()
+        }
+    }
+
+    /**
+     * @see lookupByIndex
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun lookupByIndex(
+        name: String,
+        indexKey: String,
+        limit: Int = 0,
+        snapshot: Snapshot? = null
+    ): List<ByteArray> {
+        return lookupByIndex(name, indexKey.toByteArray(), limit, snapshot)
+    }
+
+    /**
+     * Re-creates all entries of the index from the existing records. Records are scanned once and
+     * indexed by [threads] native workers. Writes to this database wait until the rebuild is done.
+     * @param name registered index name
+     * @param threads number of indexing workers
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun rebuildIndex(name: String, threads: Int = Runtime.getRuntime().availableProcessors()) {
+        handle.use { nrebuildIndex(it, name, threads) }
+    }
+
+    /**
+     * Writes a consistent copy of this database to [targetDir] while it keeps serving reads and writes.
      *
+     * Table files are immutable, so they are hard-linked when [targetDir] is on the same filesystem and copied
+     * otherwise; MANIFEST and logs are copied up to the state of the checkpoint. Writes wait only while
+     * the file list is being captured. The checkpoint is a regular database directory and can be opened as is.
      *
-     * Use before calling any of the nat functions that require the ndb pointer.
+     * Checkpoints of [in-memory][isInMemory] databases are always written to the filesystem, which makes this
+     * the way to persist them. Load them back with [LevelDB.openInMemory].
      *
+     * @param targetDir directory of the checkpoint, its parent must exist
+     * @param incremental if false, [targetDir] must be missing or empty. If true, [targetDir] may contain
+     * a previous checkpoint of this database: only new table files are copied. The new checkpoint is written to
+     * `[targetDir].tmp` and replaces the previous one once complete, so a crash leaves the previous one intact
+     * @return sequence of the last write contained in the checkpoint
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun checkpoint(targetDir: String, incremental: Boolean = false): Long {
+        return handle.use { ncheckpoint(it, targetDir, incremental) }
+    }
+
+    /**
+     * Streams the records from [start] up to [limit] to [file], which is created or truncated. Records are read and
+     * encoded natively and reach the file in blocks of about a megabyte, without passing through the JVM; index
+     * entries are left out. Load the stream into another database with [importFrom].
+     *
+     * Unlike a [checkpoint], an export holds only the live records, in a portable format, and can be limited
+     * to a key range.
      *
-     * Don't call this outside a synchronized context.
+     * @param start first key to export, null for the first key of the database
+     * @param limit key to stop at, exclusive, null for the end of the database
+     * @param snapshot snapshot to export, null for the current state
+     * @param compress whether to deflate the blocks, which needs the library to have been built with zlib
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun exportTo(
+        file: File,
+        start: ByteArray? = null,
+        limit: ByteArray? = null,
+        snapshot: Snapshot? = null,
+        compress: Boolean = false
+    ): TransferStats {
+        return export(-1, file.absolutePath, null, start, limit, snapshot, compress)
+    }
+
+    /**
+     * Streams the records from [start] up to [limit] to [stream] like [exportTo] a file. The stream is written to on
+     * the calling thread, a block at a time, and is flushed but not closed. Exceptions it throws are rethrown.
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun exportTo(
+        stream: OutputStream,
+        start: ByteArray? = null,
+        limit: ByteArray? = null,
+        snapshot: Snapshot? = null,
+        compress: Boolean = false
+    ): TransferStats {
+        return export(-1, null, stream, start, limit, snapshot, compress)
+    }
+
+    /**
+     * Streams the records from [start] up to [limit] to the open file descriptor [fd], e.g. a socket or pipe from
+     * `ParcelFileDescriptor`, like [exportTo] a file. The descriptor is not closed. Not supported on Windows.
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun exportToFd(
+        fd: Int,
+        start: ByteArray? = null,
+        limit: ByteArray? = null,
+        snapshot: Snapshot? = null,
+        compress: Boolean = false
+    ): TransferStats {
+        return export(fd, null, null, start, limit, snapshot, compress)
+    }
+
+    /**
+     * Writes the records of a stream written by [exportTo], in batches of a few megabytes. Indexes, the change
+     * feed and the row cache are kept up to date as for any other write. Existing records with the same keys
+     * are overwritten. Records whose keys are reserved for index entries are not written, they are counted in
+     * [TransferStats.skipped].
+     *
+     * The stream is checksummed. If it turns out to be corrupt or truncated, [LevelDBException] is thrown and the
+     * batches written so far stay.
+     * @param sync whether every batch is synced to disk
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun importFrom(file: File, sync: Boolean = false): TransferStats {
+        return import(-1, file.absolutePath, null, sync)
+    }
+
+    /**
+     * Writes the records of a stream written by [exportTo] like [importFrom] a file. [stream] is read on the
+     * calling thread, not past the end of the export, and is not closed.
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun importFrom(stream: InputStream, sync: Boolean = false): TransferStats {
+        return import(-1, null, stream, sync)
+    }
+
+    /**
+     * Writes the records of a stream written by [exportTo], read from the open file descriptor [fd], like
+     * [importFrom] a file. The descriptor is not closed. Not supported on Windows.
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun importFromFd(fd: Int, sync: Boolean = false): TransferStats {
+        return import(fd, null, null, sync)
+    }
+
+    private fun export(
+        fd: Int,
+        path: String?,
+        stream: OutputStream?,
+        start: ByteArray?,
+        limit: ByteArray?,
+        snapshot: Snapshot?,
+        compress: Boolean
+    ): TransferStats {
+        val stats = handle.use { ndb ->
+            withSnapshot(snapshot) { nexport(ndb, it, start, limit, fd, path, stream, compress) }
+        }
+        return TransferStats(records = stats[0], bytes = stats[1], skipped = stats[2])
+    }
+
+    private fun import(fd: Int, path: String?, stream: InputStream?, sync: Boolean): TransferStats {
+        val stats = handle.use { nimport(it, fd, path, stream, sync) }
+        return TransferStats(records = stats[0], bytes = stats[1], skipped = stats[2])
+    }
+
+    /**
+     * Writes a key-value record, unless leveldb would make the write wait for a flush or a compaction, or
+     * the write throttle would delay it, so callers can shed or queue load instead.
+     *
+     * Best effort: the level-0 file count and the size of the memtables are checked right before writing, but a
+     * flush or compaction leveldb starts in between can still make the write wait.
+     * @param key the key
+     * @param value the value
+     * @param sync whether this is a synchronous (true) or asynchronous (false) write
+     * @return 0 if written, otherwise nothing was written and the value is a hint, in milliseconds,
+     * when to try again
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun tryPut(key: ByteArray, value: ByteArray, sync: Boolean = false): Long {
+        return handle.use { ntryPut(it, sync, key, value) }
+    }
+
+    @Throws(LevelDBException::class)
+    fun tryPut(key: String, value: String, sync: Boolean = false): Long {
+        return tryPut(key.toByteArray(), value.toByteArray(), sync)
+    }
+
+    /**
+     * Writes a [WriteBatch] like [tryPut] writes a record.
+     * @return 0 if written, otherwise nothing was written and the value is a hint, in milliseconds,
+     * when to try again
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBException::class)
+    fun tryWrite(writeBatch: WriteBatch, sync: Boolean = false): Long {
+        return handle.use { ndb ->
+            NativeWriteBatch(writeBatch).use { batch ->
+                ntryWrite(ndb, sync, batch.nativePointer())
+            }
+        }
+    }
+
+    /**
+     * Current write-pressure signals and stall counters.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun writePressure(): WritePressure {
+        val stats = handle.use { nwritePressure(it) }
+        return WritePressure(
+            l0Files = stats[0].toInt(),
+            flushInProgress = stats[1] != 0L,
+            stalledWriters = stats[2].toInt(),
+            stalls = stats[3],
+            stallMicros = stats[4],
+            throttledWrites = stats[5],
+            throttleMicros = stats[6]
+        )
+    }
+
+    /**
+     * Counters of the row cache. All zeros if [LevelDB.Config.rowCacheSize] is 0.
+     *
+     * Only reads without a snapshot go through the row cache.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun rowCacheStats(): RowCacheStats {
+        val stats = handle.use { nrowCacheStats(it) }
+        return RowCacheStats(hits = stats[0], misses = stats[1], usage = stats[2], capacity = stats[3])
+    }
+
+    /**
+     * Native memory this database takes right now, by component. [LevelDB.setMemoryBudget] limits it for all
+     * databases together.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun memoryUsage(): MemoryUsage {
+        val usage = handle.use { nmemoryUsage(it) }
+        return MemoryUsage(
+            memtables = usage[0],
+            blockCache = usage[1],
+            rowCache = usage[2],
+            tableIndexes = usage[3],
+            iterators = usage[4],
+            files = usage[5]
+        )
+    }
+
+    /**
+     * Sequence of the last write to this database. Every written record (not batch) advances it by one.
+     * Sequences are counted from zero every time the database is opened.
+     * @throws LevelDBClosedException
+     */
+    @get:Throws(LevelDBClosedException::class)
+    val lastSequence: Long
+        get() = handle.use { nlastSequence(it) }
+
+    /**
+     * Opens a cursor over the change feed: every put and delete written to this database after [afterSequence],
+     * in write order, including the records of write batches and transactions. Index entries are not included.
+     *
+     * The feed is kept in memory and holds the last [LevelDB.Config.changeFeedBufferSize] bytes of records, so
+     * consumers that fall that far behind get [com.edwardstock.leveldb.exception.LevelDBChangeFeedTruncatedException]
+     * and have to resynchronize, e.g. from [checkpoint], which returns the sequence to resume from.
+     * @param afterSequence sequence of the last record already seen, [lastSequence] by default
+     * @throws LevelDBClosedException
+     * @throws IllegalStateException if the change feed is disabled
+     */
+    @Throws(LevelDBClosedException::class)
+    fun changes(afterSequence: Long = lastSequence): ChangeCursor {
+        check(config.changeFeedBufferSize > 0) { "Change feed is disabled, set Config.changeFeedBufferSize" }
+        checkIfClosed()
+        return NativeChangeCursor(this, afterSequence)
+    }
+
+    internal fun readChanges(afterSequence: Long, maxRecords: Int): List<ChangeEvent> {
+        val buffer = ByteBuffer.wrap(handle.use { nreadChanges(it, afterSequence, maxRecords) })
+        val events = ArrayList<ChangeEvent>()
+        while (buffer.hasRemaining()) {
+            val sequence = buffer.long
+            val put = buffer.get() != 0.toByte()
+            val key = ByteArray(buffer.int).also { buffer.get(it) }
+            val value = ByteArray(buffer.int).also { buffer.get(it) }
+            events.add(ChangeEvent(sequence, key, if (put) value else null))
+        }
+        return events
+    }
+
+    /**
+     * Begins an optimistic transaction over this database.
+     *
+     * The returned transaction is not thread safe and must be closed (committed or rolled back).
+     * Transactions still open are rolled back when this database is closed.
+     * @return a new transaction
+     * @throws LevelDBClosedException
+     * @see com.edwardstock.leveldb.Transaction
+     */
+    @Throws(LevelDBClosedException::class)
+    fun beginTransaction(): Transaction {
+        return handle.use { ndb ->
+            val transaction = NativeTransaction(nbeginTransaction(ndb), this)
+            transactions.add(transaction)
+            transaction
+        }
+    }
+
+    /**
+     * Runs [block] in a new transaction and commits it. On a conflict the whole block is run again
+     * in a fresh transaction, up to [maxAttempts] times in total.
+     * @return result of the last run of [block]
+     * @throws LevelDBTransactionConflictException if all attempts conflicted
+     * @throws LevelDBException
+     */
+    @Throws(LevelDBTransactionConflictException::class, LevelDBException::class)
+    fun <T> inTransaction(maxAttempts: Int = 3, sync: Boolean = false, block: Transaction.() -> T): T {
+        var attempt = 0
+        while (true) {
+            beginTransaction().use { tx ->
+                val result = tx.block()
+                try {
+                    tx.commit(sync)
+                    return result
+                } catch (e: LevelDBTransactionConflictException) {
+                    if (++attempt >= maxAttempts) {
+                        throw e
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Open snapshots, and how many of them have expired by [LevelDB.Config.snapshotMaxAge].
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun snapshotStats(): SnapshotStats {
+        val stats = handle.use { nsnapshotStats(it) }
+        return SnapshotStats(
+            count = stats[0],
+            oldestSequence = stats[1],
+            oldestAgeMillis = stats[2],
+            expired = expiredSnapshots.get()
+        )
+    }
+
+    private fun expireSnapshots() {
+        val deadline = System.nanoTime() - TimeUnit.MILLISECONDS.toNanos(config.snapshotMaxAge)
+        for (snapshot in snapshots) {
+            if (snapshot.createdAt - deadline > 0) {
+                continue
+            }
+            try {
+                handle.use { ndb ->
+                    if (snapshot.handle.close { nreleaseSnapshot(ndb, it) }) {
+                        expiredSnapshots.incrementAndGet()
+                        reportLeak(snapshot, true)
+                    }
+                    snapshots.remove(snapshot)
+                }
+            } catch (e: LevelDBClosedException) {
+                return
+            }
+        }
+    }
+
+    /**
+     * Waits up to [timeoutMillis] for events and copies them into [buffer], [NativeEventDispatcher.FIELDS] longs
+     * each. Returns the number of events.
+     */
+    internal fun pollEvents(buffer: LongArray, timeoutMillis: Int): Int {
+        return handle.use { npollEvents(it, buffer, timeoutMillis) }
+    }
+
+    private fun reportLeak(snapshot: NativeSnapshot, expired: Boolean) {
+        val listener = config.snapshotLeakListener ?: return
+        val age = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - snapshot.createdAt)
+        listener(SnapshotLeak(age, expired, snapshot.origin))
+    }
+
+    /**
+     * Runs [block] with the native pointer of the snapshot, or 0 for null, checking that this database owns it.
+     * The snapshot can't be released while [block] runs.
+     * @throws LevelDBSnapshotOwnershipException
+     * @throws LevelDBClosedException if the snapshot has been released
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
+    private inline fun <T> withSnapshot(snapshot: Snapshot?, block: (Long) -> T): T {
+        if (snapshot == null) {
+            return block(0)
+        }
+        if (snapshot !is NativeSnapshot || !snapshot.checkOwner(this)) {
+            throw LevelDBSnapshotOwnershipException()
+        }
+        return snapshot.handle.use(block)
+    }
+
+    /**
+     * Checks if this database has been closed. If it has, throws a [com.edwardstock.leveldb.exception.LevelDBClosedException].
+     *
+     *
+     * Native calls don't need it, they go through the handle, which does the same check without racing [close].
      * @throws LevelDBClosedException
      */
     @Throws(LevelDBClosedException::class)
@@ -261,6 +986,16 @@ class NativeLevelDB(
             loadNative()
         }
 
+        private const val MIN_EXPIRY_PERIOD = 10L
+        private const val MAX_EXPIRY_PERIOD = 1000L
+
+        // Shared by all databases, expiring snapshots takes next to no time.
+        private val expiryExecutor: ScheduledExecutorService by lazy {
+            Executors.newSingleThreadScheduledExecutor { runnable ->
+                Thread(runnable, "leveldb-snapshot-expiry").apply { isDaemon = true }
+            }
+        }
+
         /**
          * @see com.edwardstock.leveldb.LevelDB.destroy
          */
@@ -277,6 +1012,28 @@ class NativeLevelDB(
             nrepair(path)
         }
 
+        /**
+         * @see com.edwardstock.leveldb.LevelDB.setMemoryBudget
+         */
+        fun setMemoryBudget(bytes: Long) {
+            nsetMemoryBudget(bytes)
+        }
+
+        /**
+         * @see com.edwardstock.leveldb.LevelDB.memoryBudget
+         */
+        fun memoryBudget(): MemoryBudget {
+            val stats = nmemoryBudgetStats()
+            return MemoryBudget(limit = stats[0], usage = stats[1], enforcements = stats[2], flushes = stats[3])
+        }
+
+        /**
+         * @see com.edwardstock.leveldb.LevelDB.trimMemory
+         */
+        fun trimMemory() {
+            ntrimMemory()
+        }
+
         // NATIVE METHODS
         /**
          * Natively opens the database.
@@ -291,6 +1048,78 @@ class NativeLevelDB(
             cacheSize: Int,
             blockSize: Int,
             writeBufferSize: Int,
+            changeFeedBufferSize: Int,
+            rowCacheSize: Int,
+            readaheadSize: Int,
+            throttleWrites: Boolean,
+            eventQueueSize: Int,
+            path: String
+        ): Long
+
+        /**
+         * Natively writes a long. The key is [key], or [longKey] encoded natively if [key] is null.
+         * Same for the other primitive methods.
+         * @throws LevelDBException
+         */
+        @Throws(LevelDBException::class)
+        private external fun nputLong(ndb: Long, sync: Boolean, key: ByteArray?, longKey: Long, value: Long)
+
+        @Throws(LevelDBException::class)
+        private external fun nputDouble(ndb: Long, sync: Boolean, key: ByteArray?, longKey: Long, value: Double)
+
+        @Throws(LevelDBException::class)
+        private external fun ngetLong(ndb: Long, key: ByteArray?, longKey: Long, defaultValue: Long, nsnapshot: Long): Long
+
+        @Throws(LevelDBException::class)
+        private external fun ngetDouble(
+            ndb: Long,
+            key: ByteArray?,
+            longKey: Long,
+            defaultValue: Double,
+            nsnapshot: Long
+        ): Double
+
+        @Throws(LevelDBException::class)
+        private external fun ngetLongs(
+            ndb: Long,
+            keys: LongArray,
+            values: LongArray,
+            defaultValue: Long,
+            nsnapshot: Long
+        ): Int
+
+        private external fun nsnapshotStats(ndb: Long): LongArray
+
+        @Throws(LevelDBException::class)
+        private external fun nincrementLong(ndb: Long, sync: Boolean, key: ByteArray?, longKey: Long, delta: Long): Long
+
+        /**
+         * Natively pops queued events, waiting up to [timeoutMillis] for the first one.
+         * @return number of events copied into [buffer]
+         */
+        private external fun npollEvents(ndb: Long, buffer: LongArray, timeoutMillis: Int): Int
+
+        /**
+         * Natively wakes up [npollEvents] for good.
+         */
+        private external fun nstopEvents(ndb: Long)
+
+        /**
+         * Natively opens a new database in memory, optionally loaded from the on-disk database at [loadFrom].
+         * @return the nat structure pointer
+         * @throws LevelDBException
+         */
+        @Throws(LevelDBException::class)
+        private external fun nopenInMemory(
+            cacheSize: Int,
+            blockSize: Int,
+            writeBufferSize: Int,
+            changeFeedBufferSize: Int,
+            rowCacheSize: Int,
+            throttleWrites: Boolean,
+            eventQueueSize: Int,
+            memoryLimit: Long,
+            loadFrom: String?,
             path: String
         ): Long
 
@@ -367,6 +1196,141 @@ class NativeLevelDB(
         private external fun niterate(ndb: Long, fillCache: Boolean, nsnapshot: Long): Long
         private external fun nsnapshot(ndb: Long): Long
         private external fun nreleaseSnapshot(ndb: Long, nsnapshot: Long)
+
+        /**
+         * Natively registers a secondary index. Pointer is unchecked.
+         * @see com.edwardstock.leveldb.IndexExtractor
+         */
+        private external fun nregisterIndex(
+            ndb: Long,
+            name: String,
+            type: Int,
+            offset: Int,
+            length: Int,
+            delimiter: Byte
+        )
+
+        @Throws(LevelDBException::class)
+        private external fun ndropIndex(ndb: Long, name: String, purge: Boolean)
+
+        @Throws(LevelDBException::class)
+        private external fun nlookupByIndex(
+            ndb: Long,
+            name: String,
+            indexKey: ByteArray,
+            limit: Int,
+            nsnapshot: Long
+        ): Array<ByteArray>
+
+        @Throws(LevelDBException::class)
+        private external fun nrebuildIndex(ndb: Long, name: String, threads: Int)
+
+        /**
+         * Natively begins an optimistic transaction. Pointer is unchecked.
+         * @return pointer to the native transaction
+         */
+        private external fun nbeginTransaction(ndb: Long): Long
+
+        /**
+         * Natively writes a checkpoint of the database. Pointer is unchecked.
+         * @return sequence of the last write in the checkpoint
+         */
+        @Throws(LevelDBException::class)
+        private external fun ncheckpoint(ndb: Long, targetDir: String, incremental: Boolean): Long
+
+        private external fun nlastSequence(ndb: Long): Long
+
+        /**
+         * @return hits, misses, usage and capacity of the row cache
+         */
+        private external fun nrowCacheStats(ndb: Long): LongArray
+
+        /**
+         * Natively writes the record unless the write would wait. Pointer is unchecked.
+         * @return 0 if written, retry-after milliseconds otherwise
+         */
+        @Throws(LevelDBException::class)
+        private external fun ntryPut(ndb: Long, sync: Boolean, key: ByteArray, value: ByteArray): Long
+
+        @Throws(LevelDBException::class)
+        private external fun ntryWrite(ndb: Long, sync: Boolean, nwb: Long): Long
+
+        /**
+         * @return l0 files, flushing, stalled writers, stalls, stall micros, throttled writes, throttle micros
+         */
+        private external fun nwritePressure(ndb: Long): LongArray
+
+        /**
+         * Natively encodes the change feed records following the sequence. Pointer is unchecked.
+         */
+        @Throws(LevelDBChangeFeedTruncatedException::class)
+        private external fun nreadChanges(ndb: Long, afterSequence: Long, maxRecords: Int): ByteArray
+
+        /**
+         * Natively exports to [stream], else to [path], else to [fd]. Pointer is unchecked.
+         * @return records and bytes written
+         */
+        @Throws(LevelDBException::class)
+        private external fun nexport(
+            ndb: Long,
+            nsnapshot: Long,
+            start: ByteArray?,
+            limit: ByteArray?,
+            fd: Int,
+            path: String?,
+            stream: OutputStream?,
+            compress: Boolean
+        ): LongArray
+
+        /**
+         * Natively imports from [stream], else from [path], else from [fd]. Pointer is unchecked.
+         * @return records and bytes read
+         */
+        @Throws(LevelDBException::class)
+        private external fun nimport(ndb: Long, fd: Int, path: String?, stream: InputStream?, sync: Boolean): LongArray
+
+        /**
+         * @return memtables, block cache, row cache, table indexes, iterators and files
+         */
+        private external fun nmemoryUsage(ndb: Long): LongArray
+
+        /**
+         * Natively sets the process-wide budget and enforces it right away.
+         */
+        private external fun nsetMemoryBudget(limit: Long)
+
+        /**
+         * @return limit, usage, enforcements and flushes
+         */
+        private external fun nmemoryBudgetStats(): LongArray
+
+        private external fun ntrimMemory()
+
+        /**
+         * Natively borrows an iterator without a snapshot from the pool. Pointer is unchecked.
+         */
+        private external fun nacquireIterator(ndb: Long): Long
+
+        /**
+         * Natively gives back an iterator from [nacquireIterator]. Pointers are unchecked.
+         */
+        private external fun nreleaseIterator(ndb: Long, nit: Long)
+
+        /**
+         * Natively encodes up to [n] records from [start] until [limit]. Pointer is unchecked.
+         */
+        @Throws(LevelDBException::class)
+        private external fun nscan(ndb: Long, start: ByteArray?, limit: ByteArray?, n: Int, nsnapshot: Long): ByteArray
+
+        /**
+         * @return hits, misses and idle iterators of the iterator pool
+         */
+        private external fun niteratorPoolStats(ndb: Long): LongArray
+
+        /**
+         * @return bytes read by the readahead tables of the database
+         */
+        private external fun nreadaheadBytesRead(ndb: Long): Long
     }
 
 }
\ No newline at end of file
@@ -39,17 +39,17 @@ import java.lang.ref.WeakReference
 open class NativeSnapshot(owner: NativeLevelDB, nsnapshot: Long) : Snapshot() {
     private val owner: WeakReference<LevelDB> = WeakReference(owner)
 
-    @Volatile
-    private var nsnapshot: Long
+    internal val handle = NativeHandle(nsnapshot, "Snapshot has been released.")
 
-    init {
-        this.nsnapshot = nsnapshot
-    }
+    // For expiry and leak reports.
+    internal val createdAt: Long = System.nanoTime()
+    internal val origin: Throwable? =
+        if (owner.config.snapshotLeakDetection) Throwable("Snapshot obtained here") else null
 
     override val isReleased: Boolean
         get() {
             val owner = owner.get()
-            return nsnapshot == 0L || owner == null || owner.isClosed
+            return handle.isClosed || owner == null || owner.isClosed
         }
 
     fun checkOwner(db: LevelDB): Boolean {
@@ -57,17 +57,10 @@ open class NativeSnapshot(owner: NativeLevelDB, nsnapshot: Long) : Snapshot() {
         return owner === db
     }
 
-    fun release(): Long {
-        val snapshot = nsnapshot
-
-        // nsnapshot may change concurrently here, but only to 0 which we're fine with
-        nsnapshot = 0
-        return snapshot
-    }
-
+    /**
+     * Native pointer of the snapshot, 0 if released.
+     */
     fun id(): Long {
-        return nsnapshot
+        return handle.rawPointer
     }
-
-
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.Transaction
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.exception.LevelDBTransactionConflictException
+
+open class NativeTransaction internal constructor(
+    ntx: Long,
+    private val owner: NativeLevelDB?
+) : Transaction() {
+    // Don't touch this or all hell breaks loose.
+    private val handle: NativeHandle
+
+    constructor(ntx: Long) : this(ntx, null)
+
+    init {
+        require(ntx != 0L) { "Native transaction pointer must not be NULL!" }
+        handle = NativeHandle(ntx, "Transaction has been closed.")
+    }
+
+    companion object {
+        @Throws(LevelDBException::class)
+        private external fun nget(ntx: Long, key: ByteArray): ByteArray?
+        private external fun nput(ntx: Long, key: ByteArray, value: ByteArray)
+        private external fun ndelete(ntx: Long, key: ByteArray)
+
+        @Throws(LevelDBTransactionConflictException::class, LevelDBException::class)
+        private external fun ncommit(ntx: Long, sync: Boolean)
+        private external fun nclose(ntx: Long)
+    }
+
+    @Throws(LevelDBException::class)
+    override fun get(key: ByteArray): ByteArray? {
+        return handle.use { nget(it, key) }
+    }
+
+    @Throws(LevelDBClosedException::class)
+    override fun put(key: ByteArray, value: ByteArray?) {
+        handle.use {
+            if (value == null) {
+                ndelete(it, key)
+            } else {
+                nput(it, key, value)
+            }
+        }
+    }
+
+    @Throws(LevelDBClosedException::class)
+    override fun del(key: ByteArray) {
+        handle.use { ndelete(it, key) }
+    }
+
+    @Throws(LevelDBTransactionConflictException::class, LevelDBException::class)
+    override fun commit(sync: Boolean) {
+        try {
+            handle.use { ncommit(it, sync) }
+        } finally {
+            close()
+        }
+    }
+
+    override val isClosed: Boolean
+        get() = handle.isClosed
+
+    override fun close() {
+        handle.close { nclose(it) }
+        owner?.forget(this)
+    }
+}
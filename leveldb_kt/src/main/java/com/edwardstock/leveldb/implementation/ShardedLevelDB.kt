@@ -0,0 +1,392 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.Iterator
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.MemoryUsage
+import com.edwardstock.leveldb.ShardRouter
+import com.edwardstock.leveldb.Snapshot
+import com.edwardstock.leveldb.WriteBatch
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.exception.LevelDBSnapshotOwnershipException
+import java.io.File
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.Future
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.locks.ReentrantReadWriteLock
+
+/**
+ * A database split into several native databases, the shards, by [router]. leveldb funnels all writes of a
+ * database through one writer and one log, so a single [NativeLevelDB] stops scaling at a few writing threads;
+ * shards are written independently, on as many cores and disks as there are shards.
+ *
+ * Shard `i` lives in the directory `shard-i` under [path], or in memory if [path] is [LevelDB.IN_MEMORY_PATH].
+ * Every shard is opened with [config], so caches and write buffers are per shard.
+ *
+ * Reads and writes of single keys go to their shard only. A [WriteBatch] is split by shard and the parts are
+ * written in parallel: each part is atomic, and snapshots and iterators see either all parts or none, but after
+ * a crash only some of them may have been written. Snapshots are taken of all shards at once, between writes.
+ * Iterators and [getAll] without a snapshot take one of their own, so they see all parts or none as well.
+ * Iterators merge the shards in key order.
+ */
+class ShardedLevelDB(
+    path: String,
+    config: Config,
+    val router: ShardRouter
+) : LevelDB(config) {
+
+    /**
+     * Opens a database of [shards] shards routed by key hash, see [ShardRouter.hash].
+     */
+    constructor(path: String, config: Config, shards: Int) : this(path, config, ShardRouter.hash(shards))
+
+    private val shards: List<NativeLevelDB>
+
+    // Writes hold the read locks of their shards, snapshots all write locks, so that snapshots are taken
+    // between writes. Writers of one shard are serialized by leveldb anyway.
+    private val locks = List(router.shards) { ReentrantReadWriteLock() }
+
+    private val executor: ExecutorService
+
+    @Volatile
+    override var isClosed: Boolean = false
+        private set
+
+    override var path: String = path
+
+    init {
+        val inMemory = path == LevelDB.IN_MEMORY_PATH
+        if (!inMemory) {
+            checkLayout(File(path), config.createIfMissing)
+        }
+
+        val opened = ArrayList<NativeLevelDB>(router.shards)
+        try {
+            for (i in 0 until router.shards) {
+                opened.add(
+                    if (inMemory) {
+                        NativeLevelDB(LevelDB.IN_MEMORY_PATH, config, true, null)
+                    } else {
+                        NativeLevelDB(shardPath(path, i), config)
+                    }
+                )
+            }
+        } catch (e: Throwable) {
+            opened.forEach { it.close() }
+            throw e
+        }
+        shards = opened
+
+        val threads = AtomicInteger()
+        executor = Executors.newCachedThreadPool { runnable ->
+            Thread(runnable, "leveldb-shard-" + threads.getAndIncrement()).apply { isDaemon = true }
+        }
+    }
+
+    /**
+     * Number of shards.
+     */
+    val shardCount: Int
+        get() = router.shards
+
+    /**
+     * The native database of shard [index], e.g. for [NativeLevelDB.writePressure]. Don't close it, and don't write
+     * keys to it that [router] routes elsewhere.
+     */
+    fun shard(index: Int): NativeLevelDB {
+        return shards[index]
+    }
+
+    /**
+     * The native database that holds [key].
+     */
+    fun shardOf(key: ByteArray): NativeLevelDB {
+        return shards[router.shardOf(key)]
+    }
+
+    /**
+     * Closes all shards. Snapshots and iterators still open are closed with them.
+     */
+    override fun close() {
+        if (isClosed) {
+            return
+        }
+        isClosed = true
+        executor.shutdown()
+        shards.forEach { it.close() }
+    }
+
+    @Throws(LevelDBException::class)
+    override fun put(key: ByteArray, value: ByteArray?, sync: Boolean) {
+        val shard = router.shardOf(key)
+        writeLocked(listOf(shard)) {
+            shards[shard].put(key, value, sync)
+        }
+    }
+
+    /**
+     * Writes the batch, split by shard. The parts for different shards are written in parallel.
+     */
+    @Throws(LevelDBException::class)
+    override fun write(writeBatch: WriteBatch, sync: Boolean) {
+        val parts = HashMap<Int, SimpleWriteBatch>()
+        for (operation in writeBatch) {
+            val shard = router.shardOf(operation.key())
+            parts.getOrPut(shard) { SimpleWriteBatch(shards[shard]) }.insert(operation)
+        }
+
+        writeLocked(parts.keys.sorted()) {
+            fanOut(parts.entries.toList()) { (shard, part) ->
+                shards[shard].write(part, sync)
+            }
+        }
+    }
+
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    override fun get(key: ByteArray, snapshot: Snapshot?): ByteArray? {
+        val shard = router.shardOf(key)
+        return shards[shard].get(key, shardSnapshot(snapshot, shard))
+    }
+
+    /**
+     * Reads several keys at once, the keys of every shard in parallel. Without a [snapshot], keys of several
+     * shards are read from a snapshot taken for the call.
+     * @return values in the order of [keys], null for missing ones
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBException::class)
+    fun getAll(keys: List<ByteArray>, snapshot: Snapshot? = null): List<ByteArray?> {
+        val byShard = keys.indices.groupBy { router.shardOf(keys[it]) }
+        val values = arrayOfNulls<ByteArray>(keys.size)
+
+        val implicit = if (snapshot == null && byShard.size > 1) obtainSnapshot() else null
+        try {
+            fanOut(byShard.entries.toList()) { (shard, indices) ->
+                val db = shards[shard]
+                val shardSnapshot = shardSnapshot(snapshot ?: implicit, shard)
+                for (i in indices) {
+                    values[i] = db.get(keys[i], shardSnapshot)
+                }
+            }
+        } finally {
+            implicit?.let { releaseImplicit(it) }
+        }
+        return values.asList()
+    }
+
+    @Throws(LevelDBException::class)
+    override fun del(key: ByteArray, sync: Boolean) {
+        val shard = router.shardOf(key)
+        writeLocked(listOf(shard)) {
+            shards[shard].del(key, sync)
+        }
+    }
+
+    /**
+     * Numeric properties, like `leveldb.num-files-at-level0`, are summed up over the shards, others are
+     * concatenated, one line per shard.
+     */
+    @Throws(LevelDBClosedException::class)
+    override fun getPropertyBytes(key: ByteArray): ByteArray? {
+        val values = shards.map { it.getProperty(key) ?: return null }
+        val numbers = values.map { it.trim().toLongOrNull() }
+        return if (numbers.all { it != null }) {
+            numbers.sumOf { it!! }.toString().toByteArray()
+        } else {
+            values.joinToString("\n").toByteArray()
+        }
+    }
+
+    /**
+     * Native memory of all shards together.
+     * @throws LevelDBClosedException
+     */
+    @Throws(LevelDBClosedException::class)
+    fun memoryUsage(): MemoryUsage {
+        val usages = shards.map { it.memoryUsage() }
+        return MemoryUsage(
+            memtables = usages.sumOf { it.memtables },
+            blockCache = usages.sumOf { it.blockCache },
+            rowCache = usages.sumOf { it.rowCache },
+            tableIndexes = usages.sumOf { it.tableIndexes },
+            iterators = usages.sumOf { it.iterators },
+            files = usages.sumOf { it.files }
+        )
+    }
+
+    /**
+     * Creates an iterator over all shards, in key order. With a hash [router], every step compares the current
+     * keys of all shards. Without a [snapshot], the iterator takes one of its own, released when it's closed.
+     */
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
+    override fun iterator(fillCache: Boolean, snapshot: Snapshot?): Iterator {
+        val implicit = if (snapshot == null && shards.size > 1) obtainSnapshot() else null
+        val children = ArrayList<Iterator>(shards.size)
+        try {
+            for (i in shards.indices) {
+                children.add(shards[i].iterator(fillCache, shardSnapshot(snapshot ?: implicit, i)))
+            }
+        } catch (e: Throwable) {
+            children.forEach { it.close() }
+            implicit?.let { releaseImplicit(it) }
+            throw e
+        }
+        return MergingIterator(children) { implicit?.let { releaseImplicit(it) } }
+    }
+
+    /**
+     * Takes a snapshot of every shard, with writes to all shards held off meanwhile.
+     */
+    @Throws(LevelDBClosedException::class)
+    override fun obtainSnapshot(): Snapshot {
+        checkIfClosed()
+        locks.forEach { it.writeLock().lock() }
+        try {
+            val snapshots = ArrayList<Snapshot>(shards.size)
+            try {
+                shards.forEach { snapshots.add(it.obtainSnapshot()) }
+            } catch (e: Throwable) {
+                snapshots.forEachIndexed { i, snapshot -> shards[i].releaseSnapshot(snapshot) }
+                throw e
+            }
+            return ShardedSnapshot(this, snapshots)
+        } finally {
+            locks.forEach { it.writeLock().unlock() }
+        }
+    }
+
+    @Throws(LevelDBSnapshotOwnershipException::class, LevelDBClosedException::class)
+    override fun releaseSnapshot(snapshot: Snapshot?) {
+        requireNotNull(snapshot) { "Snapshot must not be null." }
+        if (snapshot !is ShardedSnapshot || !snapshot.checkOwner(this)) {
+            throw LevelDBSnapshotOwnershipException()
+        }
+        snapshot.snapshots.forEachIndexed { i, shardSnapshot -> shards[i].releaseSnapshot(shardSnapshot) }
+    }
+
+    /**
+     * Releases a snapshot taken for a single read. Snapshots of a closed database have been released with it.
+     */
+    private fun releaseImplicit(snapshot: Snapshot) {
+        try {
+            releaseSnapshot(snapshot)
+        } catch (e: LevelDBClosedException) {
+            // Released on close.
+        }
+    }
+
+    @Throws(LevelDBSnapshotOwnershipException::class)
+    private fun shardSnapshot(snapshot: Snapshot?, shard: Int): Snapshot? {
+        if (snapshot == null) {
+            return null
+        }
+        if (snapshot !is ShardedSnapshot || !snapshot.checkOwner(this)) {
+            throw LevelDBSnapshotOwnershipException()
+        }
+        return snapshot.snapshots[shard]
+    }
+
+    private inline fun <T> writeLocked(sortedShards: List<Int>, block: () -> T): T {
+        checkIfClosed()
+        var locked = 0
+        try {
+            for (shard in sortedShards) {
+                locks[shard].readLock().lock()
+                locked++
+            }
+            return block()
+        } finally {
+            for (i in 0 until locked) {
+                locks[sortedShards[i]].readLock().unlock()
+            }
+        }
+    }
+
+    /**
+     * Runs [block] for every item, all but the first on the executor, and rethrows the first failure.
+     */
+    private fun <T> fanOut(items: List<T>, block: (T) -> Unit) {
+        if (items.size == 1) {
+            block(items[0])
+            return
+        }
+
+        val futures = ArrayList<Future<*>>(items.size - 1)
+        for (i in 1 until items.size) {
+            futures.add(executor.submit { block(items[i]) })
+        }
+
+        var failure: Throwable? = null
+        try {
+            if (items.isNotEmpty()) {
+                block(items[0])
+            }
+        } catch (e: Throwable) {
+            failure = e
+        }
+        for (future in futures) {
+            try {
+                future.get()
+            } catch (e: ExecutionException) {
+                if (failure == null) {
+                    failure = e.cause
+                }
+            }
+        }
+        failure?.let { throw it }
+    }
+
+    @Throws(LevelDBClosedException::class)
+    private fun checkIfClosed() {
+        if (isClosed) {
+            throw LevelDBClosedException()
+        }
+    }
+
+    /**
+     * Checks that [directory] holds as many shards as the router routes to, so that a different router can't
+     * silently lose keys. New directories are given a marker with the shard count.
+     */
+    private fun checkLayout(directory: File, createIfMissing: Boolean) {
+        val marker = File(directory, SHARDS_FILE)
+        if (marker.exists()) {
+            val shards = marker.readText().trim().toIntOrNull()
+            if (shards != router.shards) {
+                throw LevelDBException("$path has $shards shards, the router routes to ${router.shards}")
+            }
+            return
+        }
+
+        if (!createIfMissing) {
+            throw LevelDBException("$path is not a sharded database")
+        }
+        if (!directory.isDirectory && !directory.mkdirs()) {
+            throw LevelDBException("Can't create $path")
+        }
+        marker.writeText(router.shards.toString())
+    }
+
+    companion object {
+        private const val SHARDS_FILE = "SHARDS"
+
+        private fun shardPath(path: String, shard: Int): String {
+            return File(path, "shard-$shard").absolutePath
+        }
+
+        /**
+         * Destroys all shards of the sharded database at [path], and the directory itself.
+         * @throws LevelDBException
+         */
+        @JvmStatic
+        @Throws(LevelDBException::class)
+        fun destroy(path: String) {
+            val directory = File(path)
+            directory.listFiles { file -> file.isDirectory && file.name.startsWith("shard-") }?.forEach {
+                NativeLevelDB.destroy(it.absolutePath)
+            }
+            File(directory, SHARDS_FILE).delete()
+            directory.delete()
+        }
+    }
+}
@@ -0,0 +1,19 @@
+package com.edwardstock.leveldb.implementation
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.Snapshot
+import java.lang.ref.WeakReference
+
+/**
+ * Snapshot of every shard of a [ShardedLevelDB], all taken at the same point between writes.
+ */
+class ShardedSnapshot internal constructor(owner: ShardedLevelDB, internal val snapshots: List<Snapshot>) : Snapshot() {
+    private val owner: WeakReference<LevelDB> = WeakReference(owner)
+
+    override val isReleased: Boolean
+        get() = snapshots.any { it.isReleased }
+
+    fun checkOwner(db: LevelDB): Boolean {
+        return owner.get() === db
+    }
+}
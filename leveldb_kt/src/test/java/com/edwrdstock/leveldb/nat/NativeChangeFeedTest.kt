@@ -0,0 +1,77 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBChangeFeedTruncatedException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwardstock.leveldb.implementation.SimpleWriteBatch
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+
+class NativeChangeFeedTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testChangesInWriteOrder() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("before", "cursor")
+
+        val cursor = db.changes()
+        Assert.assertTrue(cursor.next().isEmpty())
+
+        db.put("a", "1")
+        SimpleWriteBatch(db)
+            .put("b", "2")
+            .del("a")
+            .commit()
+
+        val events = cursor.next()
+        Assert.assertEquals(listOf("a", "b", "a"), events.map { String(it.key) })
+        Assert.assertEquals("1", String(events[0].value!!))
+        Assert.assertEquals("2", String(events[1].value!!))
+        Assert.assertTrue(events[2].isDelete)
+        Assert.assertEquals(listOf(2L, 3L, 4L), events.map { it.sequence })
+        Assert.assertEquals(db.lastSequence, cursor.position)
+        Assert.assertTrue(cursor.next().isEmpty())
+
+        // Resuming from a known sequence, in batches
+        val resumed = db.changes(afterSequence = 1)
+        Assert.assertEquals(2, resumed.next(maxRecords = 2).size)
+        Assert.assertEquals(1, resumed.next(maxRecords = 2).size)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testTruncated() {
+        val db = obtainLevelDB() as NativeLevelDB
+        val cursor = db.changes()
+
+        for (i in 0 until 1000) {
+            db.put("key$i", "value$i".repeat(10))
+        }
+
+        var threw = false
+        try {
+            cursor.next()
+        } catch (e: LevelDBChangeFeedTruncatedException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+
+        val recent = db.changes(db.lastSequence - 10).next()
+        Assert.assertEquals(10, recent.size)
+        Assert.assertEquals("key999", String(recent.last().key))
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(
+            dbFile.absolutePath,
+            LevelDB.Config(createIfMissing = true, changeFeedBufferSize = 16 * 1024)
+        )
+    }
+}
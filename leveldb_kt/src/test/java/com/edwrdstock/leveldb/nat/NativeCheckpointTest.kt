@@ -0,0 +1,176 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.After
+import org.junit.Assert
+import org.junit.Test
+import java.io.File
+import java.util.concurrent.atomic.AtomicBoolean
+import kotlin.concurrent.thread
+
+class NativeCheckpointTest : DatabaseTestCase() {
+
+    private val checkpointDir: File by lazy {
+        File(dbFile.parentFile, dbFile.name + ".checkpoint")
+    }
+
+    @After
+    fun removeCheckpoint() {
+        checkpointDir.deleteRecursively()
+        File(checkpointDir.path + ".tmp").deleteRecursively()
+        File(checkpointDir.path + ".old").deleteRecursively()
+    }
+
+    private fun openCheckpoint(): NativeLevelDB {
+        return NativeLevelDB(checkpointDir.absolutePath, LevelDB.Config())
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCheckpoint() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 20000) {
+            db.put("key$i", "value$i".repeat(10))
+        }
+
+        val sequence = db.checkpoint(checkpointDir.absolutePath)
+        Assert.assertTrue(sequence >= 20000)
+
+        db.put("key0", "changed")
+        db.put("after", "checkpoint")
+
+        val copy = openCheckpoint()
+        Assert.assertEquals("value0".repeat(10), copy.getString("key0"))
+        Assert.assertEquals("value19999".repeat(10), copy.getString("key19999"))
+        Assert.assertNull(copy.getString("after"))
+        copy.close()
+
+        var threw = false
+        try {
+            db.checkpoint(checkpointDir.absolutePath)
+        } catch (e: LevelDBException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIncrementalCheckpoint() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 20000) {
+            db.put("key$i", "value$i".repeat(10))
+        }
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+
+        for (i in 0 until 20000) {
+            db.put("more$i", "value$i".repeat(10))
+        }
+        db.del("key0")
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+
+        val copy = openCheckpoint()
+        Assert.assertNull(copy.getString("key0"))
+        Assert.assertEquals("value1".repeat(10), copy.getString("key1"))
+        Assert.assertEquals("value19999".repeat(10), copy.getString("more19999"))
+        copy.close()
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIncrementalCheckpointAfterCrash() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 20000) {
+            db.put("key$i", "value$i".repeat(10))
+        }
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+
+        // Crashed between the renames of a swap, with a half-written new checkpoint.
+        val staging = File(checkpointDir.path + ".tmp")
+        Assert.assertTrue(staging.mkdir())
+        File(staging, "CURRENT").writeText("garbage")
+        Assert.assertTrue(checkpointDir.renameTo(File(checkpointDir.path + ".old")))
+
+        db.put("key0", "changed")
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+        Assert.assertFalse(staging.exists())
+        Assert.assertFalse(File(checkpointDir.path + ".old").exists())
+
+        val copy = openCheckpoint()
+        Assert.assertEquals("changed", copy.getString("key0"))
+        Assert.assertEquals("value19999".repeat(10), copy.getString("key19999"))
+        copy.close()
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIncrementalCheckpointReplacesSubdirectories() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("key0", "value0")
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+
+        val nested = File(checkpointDir, "nested/deeper")
+        Assert.assertTrue(nested.mkdirs())
+        File(nested, "file").writeText("stray")
+
+        db.put("key0", "changed")
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+        db.put("key1", "value1")
+        db.checkpoint(checkpointDir.absolutePath, incremental = true)
+        Assert.assertFalse(File(checkpointDir.path + ".old").exists())
+        Assert.assertFalse(File(checkpointDir, "nested").exists())
+
+        val copy = openCheckpoint()
+        Assert.assertEquals("changed", copy.getString("key0"))
+        Assert.assertEquals("value1", copy.getString("key1"))
+        copy.close()
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCheckpointDuringCompactions() {
+        val db = NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, writeBufferSize = 64 * 1024))
+
+        // Flushes and compactions run while the checkpoint is taken.
+        val done = AtomicBoolean(false)
+        val writer = thread {
+            var i = 0
+            while (!done.get()) {
+                db.put("key${i++ % 50000}", "value$i".repeat(10))
+            }
+        }
+
+        Thread.sleep(200)
+        db.checkpoint(checkpointDir.absolutePath)
+        done.set(true)
+        writer.join()
+
+        // leveldb deletes the tables its MANIFEST doesn't reference when it
+        // opens, and may add one for the records it recovers from the logs.
+        val tables = { checkpointDir.list { _, name -> name.endsWith(".ldb") }!!.toSet() }
+        val copied = tables()
+        Assert.assertFalse(copied.isEmpty())
+        val copy = openCheckpoint()
+        Assert.assertTrue(tables().containsAll(copied))
+        Assert.assertNotNull(copy.getString("key0"))
+        copy.close()
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
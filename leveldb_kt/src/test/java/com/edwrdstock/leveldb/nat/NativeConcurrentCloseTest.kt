@@ -0,0 +1,107 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicReference
+
+class NativeConcurrentCloseTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testCloseWhileInUse() {
+        val db = obtainLevelDB()
+        db.put("key", "value")
+
+        val started = CountDownLatch(8)
+        val closedSeen = AtomicInteger()
+        val failure = AtomicReference<Throwable>()
+
+        val threads = (0 until 8).map { n ->
+            Thread {
+                started.countDown()
+                try {
+                    var i = 0
+                    while (true) {
+                        db.put("key$n-$i", "value$i")
+                        Assert.assertEquals("value", db.getString("key"))
+                        db.iterator().use { it.seekToFirst() }
+                        i++
+                    }
+                } catch (e: LevelDBClosedException) {
+                    closedSeen.incrementAndGet()
+                } catch (e: Throwable) {
+                    failure.set(e)
+                }
+            }.apply { start() }
+        }
+
+        started.await()
+        Thread.sleep(50)
+        db.close()
+        threads.forEach { it.join() }
+
+        Assert.assertNull(failure.get())
+        Assert.assertEquals(8, closedSeen.get())
+        Assert.assertTrue(db.isClosed)
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCloseReleasesChildren() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("key", "value")
+
+        val snapshot = db.obtainSnapshot()
+        val iterator = db.iterator(false, snapshot)
+        val transaction = db.beginTransaction()
+
+        db.close()
+
+        Assert.assertTrue(snapshot.isReleased)
+        Assert.assertTrue(iterator.isClosed)
+        try {
+            iterator.seekToFirst()
+            Assert.fail("Iterator should have been closed")
+        } catch (e: LevelDBClosedException) {
+            // expected
+        }
+        try {
+            transaction.commit()
+            Assert.fail("Transaction should have been closed")
+        } catch (e: LevelDBClosedException) {
+            // expected
+        }
+
+        // Closing them again is a no-op.
+        iterator.close()
+        transaction.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReleasedSnapshot() {
+        val db = obtainLevelDB()
+        val snapshot = db.obtainSnapshot()
+        db.releaseSnapshot(snapshot)
+
+        try {
+            db.get("key".toByteArray(), snapshot)
+            Assert.fail("Snapshot should have been released")
+        } catch (e: LevelDBClosedException) {
+            // expected
+        }
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
@@ -0,0 +1,104 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.LevelDBEvent
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.util.concurrent.CopyOnWriteArrayList
+
+class NativeEventListenerTest : DatabaseTestCase() {
+
+    private val events = CopyOnWriteArrayList<LevelDBEvent>()
+
+    @Test
+    @Throws(Exception::class)
+    fun testFlushAndCompactionEvents() {
+        val db = obtainLevelDB()
+        writeMegabytes(db, 4)
+
+        awaitEvent { it is LevelDBEvent.CompactionCompleted }
+        db.close()
+
+        val flushes = events.filterIsInstance<LevelDBEvent.FlushCompleted>()
+        Assert.assertTrue(flushes.isNotEmpty())
+        Assert.assertTrue(flushes.all { it.succeeded && it.bytes > 0 })
+        Assert.assertTrue(events.any { it is LevelDBEvent.FlushStarted && it.tableNumber == flushes[0].tableNumber })
+
+        val started = events.filterIsInstance<LevelDBEvent.CompactionStarted>()
+        Assert.assertTrue(started.isNotEmpty())
+        Assert.assertEquals(0, started[0].level)
+        Assert.assertTrue(started[0].inputFiles >= 4)
+
+        val compaction = events.filterIsInstance<LevelDBEvent.CompactionCompleted>()[0]
+        Assert.assertTrue(compaction.succeeded)
+        Assert.assertTrue(compaction.bytesRead > 0)
+        Assert.assertTrue(compaction.bytesWritten > 0)
+        Assert.assertTrue(compaction.durationMicros > 0)
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testSlowListenerDropsEvents() {
+        val db = NativeLevelDB(
+            dbFile.absolutePath,
+            config().apply {
+                eventQueueSize = 2
+                eventListener = { event ->
+                    events.add(event)
+                    Thread.sleep(50)
+                }
+            }
+        )
+
+        writeMegabytes(db, 4)
+
+        awaitEvent { it is LevelDBEvent.EventsDropped }
+        db.close()
+
+        Assert.assertTrue(events.filterIsInstance<LevelDBEvent.EventsDropped>().all { it.count > 0 })
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCloseStopsDispatcher() {
+        val db = obtainLevelDB()
+        db.put("key", "value")
+        db.close()
+
+        val deadline = System.currentTimeMillis() + 5000
+        while (Thread.getAllStackTraces().keys.any { it.name == "leveldb-events" && it.isAlive }) {
+            Assert.assertTrue(System.currentTimeMillis() < deadline)
+            Thread.sleep(10)
+        }
+    }
+
+    private fun writeMegabytes(db: LevelDB, megabytes: Int) {
+        val value = ByteArray(1024) { it.toByte() }
+        for (i in 0 until megabytes * 1024) {
+            db.put("key$i".toByteArray(), value)
+        }
+    }
+
+    private fun awaitEvent(predicate: (LevelDBEvent) -> Boolean) {
+        val deadline = System.currentTimeMillis() + 10_000
+        while (events.none(predicate)) {
+            Assert.assertTrue("Event not delivered in time", System.currentTimeMillis() < deadline)
+            Thread.sleep(10)
+        }
+    }
+
+    private fun config(): LevelDB.Config {
+        return LevelDB.Config(
+            createIfMissing = true,
+            writeBufferSize = 64 * 1024,
+            eventListener = { events.add(it) }
+        )
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, config())
+    }
+}
@@ -0,0 +1,168 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.IndexExtractor
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.After
+import org.junit.Assert
+import org.junit.Test
+import java.io.ByteArrayInputStream
+import java.io.ByteArrayOutputStream
+import java.io.File
+
+class NativeExportImportTest : DatabaseTestCase() {
+
+    private val exportFile: File by lazy {
+        File(dbFile.parentFile, dbFile.name + ".export")
+    }
+
+    private val targetDir: File by lazy {
+        File(dbFile.parentFile, dbFile.name + ".target")
+    }
+
+    @After
+    fun removeExport() {
+        exportFile.delete()
+        NativeLevelDB.destroy(targetDir.absolutePath)
+    }
+
+    private fun openTarget(): NativeLevelDB {
+        return NativeLevelDB(targetDir.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+
+    private fun keys(db: LevelDB): List<String> {
+        val keys = ArrayList<String>()
+        db.iterator().use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                keys.add(String(iterator.key()))
+                iterator.next()
+            }
+        }
+        return keys
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testFileRoundTrip() {
+        val db = obtainLevelDB() as NativeLevelDB
+        // Several blocks, and a record larger than a block.
+        for (i in 0 until 20000) {
+            db.put(String.format("key%05d", i), "value$i".repeat(10))
+        }
+        db.put("large".toByteArray(), ByteArray(3 shl 20) { it.toByte() })
+
+        val exported = db.exportTo(exportFile)
+        Assert.assertEquals(20001L, exported.records)
+        Assert.assertEquals(exportFile.length(), exported.bytes)
+        db.close()
+
+        val target = openTarget()
+        val imported = target.importFrom(exportFile)
+        Assert.assertEquals(exported, imported)
+
+        Assert.assertEquals("value7".repeat(10), target.getString("key00007"))
+        Assert.assertArrayEquals(ByteArray(3 shl 20) { it.toByte() }, target["large".toByteArray()])
+        Assert.assertEquals(20001, keys(target).size)
+        target.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testStreamRangeAndSnapshot() {
+        val db = obtainLevelDB() as NativeLevelDB
+        listOf("a", "b", "c", "d", "e").forEach { db.put(it, it) }
+
+        val snapshot = db.obtainSnapshot()
+        db.put("c", "changed")
+
+        val out = ByteArrayOutputStream()
+        val stats = db.exportTo(out, "b".toByteArray(), "e".toByteArray(), snapshot)
+        db.releaseSnapshot(snapshot)
+        Assert.assertEquals(3L, stats.records)
+        Assert.assertEquals(out.size().toLong(), stats.bytes)
+        db.close()
+
+        val target = openTarget()
+        target.importFrom(ByteArrayInputStream(out.toByteArray()))
+        Assert.assertEquals(listOf("b", "c", "d"), keys(target))
+        Assert.assertEquals("c", target.getString("c"))
+        target.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCompressed() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 10000) {
+            db.put("key$i", "a highly compressible value")
+        }
+
+        val plain = db.exportTo(ByteArrayOutputStream())
+        val compressed = db.exportTo(exportFile, compress = true)
+        Assert.assertTrue(compressed.bytes < plain.bytes / 2)
+        db.close()
+
+        val target = openTarget()
+        Assert.assertEquals(10000L, target.importFrom(exportFile).records)
+        Assert.assertEquals("a highly compressible value", target.getString("key9999"))
+        target.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIndexesRebuiltOnImport() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        db.put("u1", "paris|alice")
+        db.put("u2", "berlin|bob")
+
+        val out = ByteArrayOutputStream()
+        Assert.assertEquals(2L, db.exportTo(out).records)
+        db.close()
+
+        val target = openTarget()
+        target.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        target.importFrom(ByteArrayInputStream(out.toByteArray()))
+        Assert.assertEquals(listOf("paris|alice"), target.lookupByIndex("city", "paris").map { String(it) })
+        target.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testTruncatedStream() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 1000) {
+            db.put("key$i", "value$i")
+        }
+
+        val out = ByteArrayOutputStream()
+        db.exportTo(out)
+        db.close()
+
+        val bytes = out.toByteArray()
+        val target = openTarget()
+        try {
+            target.importFrom(ByteArrayInputStream(bytes, 0, bytes.size - 4))
+            Assert.fail("Importing a truncated stream should fail")
+        } catch (e: LevelDBException) {
+            // expected
+        }
+
+        bytes[bytes.size / 2] = (bytes[bytes.size / 2] + 1).toByte()
+        try {
+            target.importFrom(ByteArrayInputStream(bytes))
+            Assert.fail("Importing a corrupt stream should fail")
+        } catch (e: LevelDBException) {
+            // expected
+        }
+        target.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
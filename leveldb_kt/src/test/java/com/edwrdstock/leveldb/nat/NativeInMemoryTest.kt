@@ -0,0 +1,126 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBIOException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.After
+import org.junit.Assert
+import org.junit.Test
+import java.io.File
+
+class NativeInMemoryTest : DatabaseTestCase() {
+
+    private val dumpDir: File by lazy {
+        File(dbFile.parentFile, dbFile.name + ".dump")
+    }
+
+    @After
+    fun removeDump() {
+        dumpDir.deleteRecursively()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReadWriteIterate() {
+        val db = obtainLevelDB() as NativeLevelDB
+        Assert.assertTrue(db.isInMemory)
+
+        db.put("b", "2")
+        db.put("a", "1")
+        db.put("c", "3")
+
+        val snapshot = db.obtainSnapshot()
+        db.del("b")
+
+        Assert.assertNull(db.getString("b"))
+        Assert.assertEquals("2", String(db.get("b".toByteArray(), snapshot)!!))
+
+        val keys = ArrayList<String>()
+        db.iterator(false, snapshot).use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                keys.add(String(iterator.key()))
+                iterator.next()
+            }
+        }
+        Assert.assertEquals(listOf("a", "b", "c"), keys)
+
+        db.releaseSnapshot(snapshot)
+        db.close()
+
+        // Nothing has been written to disk.
+        Assert.assertFalse(File(LevelDB.IN_MEMORY_PATH).exists())
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testSeparateInstances() {
+        val first = obtainLevelDB()
+        val second = obtainLevelDB()
+
+        first.put("key", "first")
+        Assert.assertNull(second.getString("key"))
+
+        first.close()
+        second.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testMemoryLimit() {
+        val db = LevelDB.openInMemory(LevelDB.Config(memoryLimit = 256 * 1024L))
+        val value = ByteArray(1024) { it.toByte() }
+
+        var written = 0
+        try {
+            for (i in 0 until 1024) {
+                db.put("key$i".toByteArray(), value)
+                written++
+            }
+            Assert.fail("Memory limit should have been hit")
+        } catch (e: LevelDBIOException) {
+            // expected
+        }
+
+        Assert.assertTrue(written > 0)
+        Assert.assertTrue(written < 256)
+        Assert.assertArrayEquals(value, db.get("key0".toByteArray()))
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testDumpAndLoad() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 1000) {
+            db.put("key$i", "value$i")
+        }
+
+        db.checkpoint(dumpDir.absolutePath)
+        db.close()
+
+        val onDisk = NativeLevelDB(dumpDir.absolutePath, LevelDB.Config(createIfMissing = false))
+        Assert.assertEquals("value999", onDisk.getString("key999"))
+        onDisk.put("extra", "disk")
+        onDisk.close()
+
+        val loaded = LevelDB.openInMemory(loadFrom = dumpDir.absolutePath)
+        Assert.assertEquals("value0", loaded.getString("key0"))
+        Assert.assertEquals("disk", loaded.getString("extra"))
+
+        // Changes stay in memory.
+        loaded.put("extra", "memory")
+        loaded.close()
+
+        val reopened = NativeLevelDB(dumpDir.absolutePath, LevelDB.Config(createIfMissing = false))
+        Assert.assertEquals("disk", reopened.getString("extra"))
+        reopened.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return LevelDB.openInMemory()
+    }
+}
@@ -0,0 +1,118 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.IndexExtractor
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+
+class NativeIteratorPoolTest : DatabaseTestCase() {
+
+    private fun keys(db: LevelDB, start: String?, limit: String?, n: Int): List<String> {
+        return db.scan(start?.toByteArray(), limit?.toByteArray(), n).map { String(it.key) }
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testScan() {
+        val db = obtainLevelDB()
+        listOf("a", "b", "c", "d", "e").forEach { db.put(it, it.uppercase()) }
+
+        Assert.assertEquals(listOf("a", "b", "c", "d", "e"), keys(db, null, null, 10))
+        Assert.assertEquals(listOf("b", "c"), keys(db, "b", null, 2))
+        Assert.assertEquals(listOf("b", "c", "d"), keys(db, "b", "e", 10))
+        Assert.assertEquals(listOf("c", "d"), keys(db, "bb", "dd", 10))
+        Assert.assertTrue(keys(db, "f", null, 10).isEmpty())
+        Assert.assertTrue(keys(db, null, null, 0).isEmpty())
+
+        val records = db.scan("c".toByteArray(), null, 1)
+        Assert.assertEquals("C", String(records.single().value))
+
+        val snapshot = db.obtainSnapshot()
+        db.put("c", "changed")
+        db.del("d")
+        Assert.assertEquals("C", String(db.scan("c".toByteArray(), null, 1, snapshot).single().value))
+        Assert.assertEquals(listOf("c", "d"), db.scan("c".toByteArray(), "e".toByteArray(), 10, snapshot).map { String(it.key) })
+        Assert.assertEquals(listOf("c"), keys(db, "c", "e", 10))
+        db.releaseSnapshot(snapshot)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReuseUntilWrite() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 100) {
+            db.put(String.format("key%03d", i), "value$i")
+        }
+
+        val before = db.iteratorPoolStats()
+        for (i in 0 until 50) {
+            Assert.assertEquals(3, db.scan(String.format("key%03d", i).toByteArray(), null, 3).size)
+        }
+        var stats = db.iteratorPoolStats()
+        Assert.assertEquals(before.misses + 1, stats.misses)
+        Assert.assertEquals(before.hits + 49, stats.hits)
+
+        Assert.assertEquals(1L, stats.idle)
+
+        // A write makes the idle iterator stale and deletes it, the next scan must see the write.
+        db.put("key000", "changed")
+        Assert.assertEquals(0L, db.iteratorPoolStats().idle)
+        Assert.assertEquals("changed", String(db.scan("key000".toByteArray(), null, 1).single().value))
+        Assert.assertEquals(stats.misses + 1, db.iteratorPoolStats().misses)
+
+        // Iterators that fill the cache come from the same pool.
+        stats = db.iteratorPoolStats()
+        db.iterator(true, null).use { iterator ->
+            iterator.seek("key000".toByteArray())
+            Assert.assertEquals("changed", String(iterator.value()))
+        }
+        Assert.assertEquals(stats.hits + 1, db.iteratorPoolStats().hits)
+
+        db.put("key001", "changed")
+        db.iterator(true, null).use { iterator ->
+            iterator.seek("key001".toByteArray())
+            Assert.assertEquals("changed", String(iterator.value()))
+        }
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIndexRebuildDropsIdleIterators() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("a", "paris|alice")
+        db.scan(null, null, 1)
+        Assert.assertEquals(1L, db.iteratorPoolStats().idle)
+
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        db.rebuildIndex("city")
+        Assert.assertEquals(0L, db.iteratorPoolStats().idle)
+
+        db.scan(null, null, 1)
+        db.dropIndex("city")
+        Assert.assertEquals(0L, db.iteratorPoolStats().idle)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testCloseWithPooledIteratorOpen() {
+        val db = obtainLevelDB()
+        db.put("key", "value")
+        val iterator = db.iterator(true, null)
+        iterator.seekToFirst()
+        db.close()
+        // Closed along with the database, closing it again is a no-op.
+        iterator.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
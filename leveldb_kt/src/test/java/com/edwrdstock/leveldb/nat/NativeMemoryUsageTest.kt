@@ -0,0 +1,152 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.After
+import org.junit.Assert
+import org.junit.Test
+
+class NativeMemoryUsageTest : DatabaseTestCase() {
+
+    @After
+    fun resetBudget() {
+        LevelDB.setMemoryBudget(0)
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testBreakdown() {
+        val db = NativeLevelDB(
+            dbFile.absolutePath,
+            LevelDB.Config(createIfMissing = true, writeBufferSize = 64 * 1024, rowCacheSize = 1024 * 1024)
+        )
+
+        for (i in 0 until 10000) {
+            db.put(String.format("key%05d", i), "value$i".repeat(10))
+        }
+        var usage = db.memoryUsage()
+        Assert.assertTrue(usage.memtables > 0)
+        Assert.assertEquals(0L, usage.files)
+
+        // Reading opens tables and fills the caches.
+        for (i in 0 until 10000 step 100) {
+            Assert.assertNotNull(db.getString(String.format("key%05d", i)))
+        }
+        usage = db.memoryUsage()
+        Assert.assertTrue(usage.blockCache > 0)
+        Assert.assertTrue(usage.rowCache > 0)
+        Assert.assertTrue(usage.tableIndexes > 0)
+        Assert.assertEquals(0L, usage.iterators)
+
+        db.iterator(false, null).use { iterator ->
+            iterator.seekToFirst()
+            Assert.assertTrue(db.memoryUsage().iterators > 0)
+        }
+        Assert.assertEquals(0L, db.memoryUsage().iterators)
+
+        Assert.assertEquals(
+            usage.memtables + usage.blockCache + usage.rowCache + usage.tableIndexes,
+            usage.total
+        )
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testInMemoryFiles() {
+        val db = LevelDB.openInMemory(LevelDB.Config(writeBufferSize = 64 * 1024)) as NativeLevelDB
+        for (i in 0 until 10000) {
+            db.put("key$i", "value$i".repeat(10))
+        }
+        Assert.assertTrue(db.memoryUsage().files > 0)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testBudgetFlushesMemtables() {
+        val db = NativeLevelDB(
+            dbFile.absolutePath,
+            LevelDB.Config(createIfMissing = true, writeBufferSize = 32 * 1024 * 1024)
+        )
+
+        val before = LevelDB.memoryBudget()
+        LevelDB.setMemoryBudget(4L * 1024 * 1024)
+
+        val value = ByteArray(1000)
+        for (i in 0 until 20000) {
+            db.put("key$i".toByteArray(), value)
+        }
+
+        // Without the budget, all 20 MB would still be in the memtable. The
+        // budget is enforced in the background, the writes don't wait for it.
+        val deadline = System.currentTimeMillis() + 10000
+        while (db.memoryUsage().memtables >= 8L * 1024 * 1024 && System.currentTimeMillis() < deadline) {
+            Thread.sleep(10)
+        }
+        Assert.assertTrue(db.memoryUsage().memtables < 8L * 1024 * 1024)
+
+        val after = LevelDB.memoryBudget()
+        Assert.assertEquals(4L * 1024 * 1024, after.limit)
+        Assert.assertTrue(after.enforcements > before.enforcements)
+        Assert.assertTrue(after.flushes > before.flushes)
+        Assert.assertEquals(value.size, db["key0".toByteArray()]!!.size)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testTryWritesCountTowardsBudget() {
+        val db = NativeLevelDB(
+            dbFile.absolutePath,
+            LevelDB.Config(createIfMissing = true, writeBufferSize = 32 * 1024 * 1024)
+        )
+
+        val before = LevelDB.memoryBudget()
+        LevelDB.setMemoryBudget(4L * 1024 * 1024)
+
+        val value = ByteArray(1000)
+        for (i in 0 until 20000) {
+            while (true) {
+                val retryAfter = db.tryPut("key$i".toByteArray(), value)
+                if (retryAfter == 0L) {
+                    break
+                }
+                Thread.sleep(retryAfter)
+            }
+        }
+
+        val deadline = System.currentTimeMillis() + 10000
+        while (LevelDB.memoryBudget().flushes == before.flushes && System.currentTimeMillis() < deadline) {
+            Thread.sleep(10)
+        }
+        Assert.assertTrue(LevelDB.memoryBudget().enforcements > before.enforcements)
+        Assert.assertTrue(LevelDB.memoryBudget().flushes > before.flushes)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testTrimMemory() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 1000) {
+            db.put("key$i", "value$i")
+        }
+        for (i in 0 until 1000) {
+            db.getString("key$i")
+        }
+        Assert.assertTrue(db.memoryUsage().rowCache > 0)
+
+        LevelDB.trimMemory()
+        Assert.assertEquals(0L, db.memoryUsage().rowCache)
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, rowCacheSize = 1024 * 1024))
+    }
+}
@@ -0,0 +1,137 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.Bytes
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.implementation.LongConverter
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+
+class NativePrimitivesTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testPutGet() {
+        val db = obtainLevelDB() as NativeLevelDB
+
+        Assert.assertEquals(-1L, db.getLong(42L, -1))
+        db.putLong(42L, Long.MIN_VALUE)
+        Assert.assertEquals(Long.MIN_VALUE, db.getLong(42L))
+
+        db.putLong("counter".toByteArray(), 7L)
+        Assert.assertEquals(7L, db.getLong("counter".toByteArray()))
+        Assert.assertEquals(7L, Bytes.toLong(db.get("counter")!!))
+
+        db.putDouble(43L, Math.PI)
+        Assert.assertEquals(Math.PI, db.getDouble(43L), 0.0)
+        Assert.assertEquals(1.5, db.getDouble(44L, 1.5), 0.0)
+
+        db.put("text", "not a long")
+        try {
+            db.getLong("text".toByteArray())
+            Assert.fail("Reading a non-primitive value should fail")
+        } catch (e: LevelDBException) {
+            // expected
+        }
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testLongKeysSortNumerically() {
+        val db = obtainLevelDB() as NativeLevelDB
+        val keys = longArrayOf(5, -1, Long.MAX_VALUE, 0, Long.MIN_VALUE, -100)
+        keys.forEach { db.putLong(it, it * 2) }
+
+        val order = ArrayList<Long>()
+        db.iterator().use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                order.add(Bytes.toLongKey(iterator.key()))
+                Assert.assertEquals(order.last() * 2, Bytes.toLong(iterator.value()))
+                iterator.next()
+            }
+        }
+
+        Assert.assertEquals(keys.sorted(), order)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testGetLongs() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0L until 100L step 2) {
+            db.putLong(i, i * i)
+        }
+
+        val keys = LongArray(100) { it.toLong() }
+        val values = LongArray(100)
+        Assert.assertEquals(50, db.getLongs(keys, values, -1))
+
+        for (i in 0 until 100) {
+            Assert.assertEquals(if (i % 2 == 0) i.toLong() * i else -1L, values[i])
+        }
+
+        val snapshot = db.obtainSnapshot()
+        db.putLong(1L, 1L)
+        Assert.assertEquals(50, db.getLongs(keys, values, -1, snapshot))
+        Assert.assertEquals(-1L, values[1])
+        db.releaseSnapshot(snapshot)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIncrementLong() {
+        val db = obtainLevelDB() as NativeLevelDB
+
+        Assert.assertEquals(1L, db.incrementLong(1L))
+        Assert.assertEquals(11L, db.incrementLong(1L, 10))
+        db.incrementLong("wrap".toByteArray(), Long.MAX_VALUE)
+        Assert.assertEquals(Long.MIN_VALUE, db.incrementLong("wrap".toByteArray()))
+
+        val threads = (0 until 8).map {
+            Thread {
+                for (i in 0 until 1000) {
+                    db.incrementLong(2L)
+                }
+            }.apply { start() }
+        }
+        threads.forEach { it.join() }
+
+        Assert.assertEquals(8000L, db.getLong(2L))
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testLongConverterValues() {
+        val db = obtainLevelDB() as NativeLevelDB
+        val converter = LongConverter()
+        val values = longArrayOf(0, 1, -1, 127, 128, -128, -129, 65535, Int.MIN_VALUE.toLong(), Long.MAX_VALUE, Long.MIN_VALUE)
+
+        // Records written by LongConverter are 1 to 8 bytes long.
+        for (value in values) {
+            val key = "old$value".toByteArray()
+            db.put(key, converter.encode(value))
+            Assert.assertEquals(value, db.getLong(key))
+            Assert.assertEquals(value, Bytes.toLong(db.get(key)!!))
+            Assert.assertEquals(value + 1, db.incrementLong(key))
+
+            db.putLong(key, value)
+            Assert.assertEquals(value, converter.decode(key, db.get(key)))
+        }
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
@@ -0,0 +1,118 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+
+class NativeReadaheadTest : DatabaseTestCase() {
+
+    private fun key(i: Int) = String.format("key%08d", i)
+
+    @Test
+    @Throws(Exception::class)
+    fun testScansAndReads() {
+        val count = 20000
+        val writer = NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, writeBufferSize = 256 * 1024))
+        for (i in 0 until count) {
+            writer.put(key(i), "value$i".repeat(20))
+        }
+        writer.close()
+
+        val db = obtainLevelDB() as NativeLevelDB
+        Assert.assertEquals("value123".repeat(20), db.getString(key(123)))
+
+        db.iterator(fillCache = false).use { iterator ->
+            var expected = 0
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                Assert.assertEquals(key(expected), String(iterator.key()))
+                Assert.assertEquals("value$expected".repeat(20), String(iterator.value()))
+                expected++
+                iterator.next()
+            }
+            Assert.assertEquals(count, expected)
+
+            iterator.seek(key(count - 1).toByteArray())
+            while (iterator.isValid) {
+                expected--
+                Assert.assertEquals(key(expected), String(iterator.key()))
+                iterator.previous()
+            }
+            Assert.assertEquals(0, expected)
+        }
+
+        Assert.assertEquals("value19999".repeat(20), db.getString(key(19999)))
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testScanAcrossLevelsReadsTablesOnce() {
+        // Every round covers the whole key range, so the tables of level 0
+        // and level 1 overlap and a scan switches between them all the time.
+        val rounds = 4
+        val count = 40000
+        val writer = NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, writeBufferSize = 256 * 1024))
+        for (round in 0 until rounds) {
+            for (i in round until count step rounds) {
+                writer.put(key(i), "value$i".repeat(20))
+            }
+        }
+        writer.close()
+
+        val tableBytes = dbFile.listFiles { file -> file.name.endsWith(".ldb") }!!.sumOf { it.length() }
+        Assert.assertTrue(tableBytes > 0)
+
+        val db = obtainLevelDB() as NativeLevelDB
+        val before = db.readaheadBytesRead()
+        var scanned = 0
+        db.iterator(fillCache = false).use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                Assert.assertEquals(key(scanned), String(iterator.key()))
+                scanned++
+                iterator.next()
+            }
+        }
+        Assert.assertEquals(count, scanned)
+
+        // Refilling the window on every switch of table reads the 1 MB
+        // window for nearly every block.
+        val read = db.readaheadBytesRead() - before
+        Assert.assertTrue("read $read bytes of $tableBytes", read < 3 * tableBytes)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testWindowsFreedWithIterator() {
+        val count = 20000
+        val writer = NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, writeBufferSize = 256 * 1024))
+        for (i in 0 until count) {
+            writer.put(key(i), "value$i".repeat(20))
+        }
+        writer.close()
+
+        val db = obtainLevelDB() as NativeLevelDB
+        db.iterator(fillCache = false).use { iterator ->
+            iterator.seekToFirst()
+            Assert.assertTrue(iterator.isValid)
+            Assert.assertTrue(db.memoryUsage().iterators >= 1024 * 1024)
+        }
+
+        // Compactions started by the open hold windows of their own until they finish.
+        val deadline = System.currentTimeMillis() + 10_000
+        while (db.memoryUsage().iterators != 0L) {
+            Assert.assertTrue(System.currentTimeMillis() < deadline)
+            Thread.sleep(10)
+        }
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, readaheadSize = 1024 * 1024))
+    }
+}
@@ -0,0 +1,70 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwardstock.leveldb.implementation.SimpleWriteBatch
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+
+class NativeRowCacheTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testCachedReadsFollowWrites() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("hot", "1")
+
+        Assert.assertEquals("1", db.getString("hot"))
+        Assert.assertEquals("1", db.getString("hot"))
+        Assert.assertNull(db.getString("missing"))
+        Assert.assertNull(db.getString("missing"))
+
+        var stats = db.rowCacheStats()
+        Assert.assertEquals(2, stats.hits)
+        Assert.assertEquals(2, stats.misses)
+        Assert.assertTrue(stats.usage > 0)
+
+        db.put("hot", "2")
+        Assert.assertEquals("2", db.getString("hot"))
+
+        db.put("missing", "found")
+        Assert.assertEquals("found", db.getString("missing"))
+
+        SimpleWriteBatch(db)
+            .put("hot", "3")
+            .del("missing")
+            .commit()
+        Assert.assertEquals("3", db.getString("hot"))
+        Assert.assertNull(db.getString("missing"))
+
+        db.del("hot")
+        Assert.assertNull(db.getString("hot"))
+
+        stats = db.rowCacheStats()
+        Assert.assertEquals(2, stats.hits)
+        Assert.assertEquals(7, stats.misses)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testSnapshotReadsBypassCache() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("key", "old")
+        val snapshot = db.obtainSnapshot()
+        db.put("key", "new")
+
+        Assert.assertEquals("new", db.getString("key"))
+        Assert.assertEquals("old", String(db.get("key".toByteArray(), snapshot)!!))
+
+        db.releaseSnapshot(snapshot)
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true, rowCacheSize = 1024 * 1024))
+    }
+}
@@ -0,0 +1,206 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.IndexExtractor
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwardstock.leveldb.implementation.SimpleWriteBatch
+import com.edwardstock.leveldb.implementation.forEachKeys
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.util.concurrent.atomic.AtomicBoolean
+import kotlin.concurrent.thread
+
+class NativeSecondaryIndexTest : DatabaseTestCase() {
+
+    private fun lookup(db: NativeLevelDB, city: String): List<String> {
+        return db.lookupByIndex("city", city).map { String(it) }
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testIndexFollowsWrites() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+
+        db.put("u1", "paris|alice")
+        db.put("u2", "berlin|bob")
+        db.put("u3", "paris|carol")
+        Assert.assertEquals(listOf("paris|alice", "paris|carol"), lookup(db, "paris"))
+
+        db.put("u1", "berlin|alice")
+        Assert.assertEquals(listOf("paris|carol"), lookup(db, "paris"))
+        Assert.assertEquals(listOf("berlin|alice", "berlin|bob"), lookup(db, "berlin"))
+
+        db.del("u3")
+        Assert.assertTrue(lookup(db, "paris").isEmpty())
+
+        SimpleWriteBatch(db)
+            .put("u4", "rome|dave")
+            .put("u4", "oslo|dave")
+            .del("u2")
+            .commit()
+        Assert.assertTrue(lookup(db, "rome").isEmpty())
+        Assert.assertEquals(listOf("oslo|dave"), lookup(db, "oslo"))
+        Assert.assertEquals(listOf("berlin|alice"), lookup(db, "berlin"))
+        Assert.assertEquals(1, db.lookupByIndex("city", "berlin", limit = 1).size)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testRebuildAndDrop() {
+        val db = obtainLevelDB() as NativeLevelDB
+        for (i in 0 until 5000) {
+            db.put("user$i", (if (i % 2 == 0) "even|" else "odd|") + i)
+        }
+
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        Assert.assertTrue(lookup(db, "even").isEmpty())
+
+        db.rebuildIndex("city", threads = 4)
+        Assert.assertEquals(2500, lookup(db, "even").size)
+        Assert.assertEquals(2500, lookup(db, "odd").size)
+
+        db.dropIndex("city")
+        var threw = false
+        try {
+            lookup(db, "even")
+        } catch (e: LevelDBException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testEntriesHiddenFromIteration() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        db.put("\u0000", "paris|zero")
+        db.put("u1", "paris|alice")
+        db.put("u2", "berlin|bob")
+
+        val keys = listOf("\u0000", "u1", "u2")
+        Assert.assertEquals(keys, db.scan(null, null, 10).map { String(it.key) })
+        Assert.assertEquals(listOf("u1"), db.scan("\u0000\u0000".toByteArray(), null, 1).map { String(it.key) })
+
+        val forward = ArrayList<String>()
+        db.forEachKeys { forward.add(it) }
+        Assert.assertEquals(keys, forward)
+
+        for (fillCache in listOf(true, false)) {
+            db.iterator(fillCache, null).use { iterator ->
+                val backward = ArrayList<String>()
+                iterator.seekToLast()
+                while (iterator.isValid) {
+                    backward.add(String(iterator.key()))
+                    iterator.previous()
+                }
+                Assert.assertEquals(keys.reversed(), backward)
+
+                iterator.seek("\u0000\u0000idx".toByteArray())
+                Assert.assertEquals("u1", String(iterator.key()))
+                iterator.previous()
+                Assert.assertEquals("\u0000", String(iterator.key()))
+            }
+        }
+
+        var threw = false
+        try {
+            db.put("\u0000\u0000idxcity", "value")
+        } catch (e: LevelDBException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+        Assert.assertEquals(listOf("paris|alice", "paris|zero"), lookup(db, "paris").sorted())
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testDropRacingWriters() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+
+        val stop = AtomicBoolean()
+        val writers = (0 until 4).map { w ->
+            thread {
+                var i = 0
+                while (!stop.get()) {
+                    db.put("w$w-${i++ % 500}", "paris|$i")
+                }
+            }
+        }
+
+        Thread.sleep(50)
+        db.dropIndex("city")
+        stop.set(true)
+        writers.forEach { it.join() }
+
+        // Nothing was indexed after the drop, a purge that raced a writer would leave entries behind.
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        Assert.assertTrue(lookup(db, "paris").isEmpty())
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReRegisterWithOtherExtractor() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        db.put("u1", "paris|berlin")
+        db.put("u2", "rome|paris")
+
+        // The same spec again keeps the entries.
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        Assert.assertEquals(listOf("paris|berlin"), lookup(db, "paris"))
+
+        db.registerIndex("city", IndexExtractor.ValueField('|', 1))
+        Assert.assertTrue(lookup(db, "paris").isEmpty())
+
+        db.put("u1", "oslo|madrid")
+        db.rebuildIndex("city")
+        Assert.assertEquals(listOf("rome|paris"), lookup(db, "paris"))
+        Assert.assertEquals(listOf("oslo|madrid"), lookup(db, "madrid"))
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testLookupSkipsStaleEntries() {
+        var db = obtainLevelDB() as NativeLevelDB
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        db.put("u1", "paris|alice")
+        db.put("u2", "paris|bob")
+        db.put("u3", "paris|carol")
+        db.close()
+
+        // Not registered after the reopen: the entries of u1 and u2 go stale.
+        db = obtainLevelDB() as NativeLevelDB
+        db.put("u1", "berlin|alice")
+        db.del("u2")
+
+        db.registerIndex("city", IndexExtractor.ValueField('|', 0))
+        Assert.assertEquals(listOf("paris|carol"), lookup(db, "paris"))
+        Assert.assertEquals(1, db.lookupByIndex("city", "paris", limit = 1).size)
+        Assert.assertTrue(lookup(db, "berlin").isEmpty())
+
+        db.rebuildIndex("city")
+        Assert.assertEquals(listOf("berlin|alice"), lookup(db, "berlin"))
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
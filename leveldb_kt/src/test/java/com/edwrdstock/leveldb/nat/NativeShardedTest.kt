@@ -0,0 +1,240 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.ShardRouter
+import com.edwardstock.leveldb.exception.LevelDBException
+import com.edwardstock.leveldb.implementation.ShardedLevelDB
+import com.edwardstock.leveldb.implementation.SimpleWriteBatch
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.After
+import org.junit.Assert
+import org.junit.Test
+
+class NativeShardedTest : DatabaseTestCase() {
+
+    @After
+    fun destroyShards() {
+        ShardedLevelDB.destroy(dbFile.absolutePath)
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testRouting() {
+        val db = obtainLevelDB() as ShardedLevelDB
+        for (i in 0 until 1000) {
+            db.put("key$i", "value$i")
+        }
+
+        for (i in 0 until 1000) {
+            Assert.assertEquals("value$i", db.getString("key$i"))
+            Assert.assertEquals("value$i", String(db.shardOf("key$i".toByteArray())["key$i"]!!))
+        }
+
+        // Hashing spreads the keys over all shards.
+        for (shard in 0 until db.shardCount) {
+            db.shard(shard).iterator().use { iterator ->
+                iterator.seekToFirst()
+                Assert.assertTrue(iterator.isValid)
+            }
+        }
+
+        db.del("key0")
+        Assert.assertNull(db.getString("key0"))
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testMergedIteration() {
+        val db = obtainLevelDB()
+        val keys = (0 until 500).map { String.format("key%04d", it) }
+        keys.shuffled().forEach { db.put(it, it) }
+
+        val forward = ArrayList<String>()
+        db.iterator().use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                forward.add(String(iterator.key()))
+                Assert.assertEquals(forward.last(), String(iterator.value()))
+                iterator.next()
+            }
+        }
+        Assert.assertEquals(keys, forward)
+
+        val backward = ArrayList<String>()
+        db.iterator().use { iterator ->
+            iterator.seekToLast()
+            while (iterator.isValid) {
+                backward.add(String(iterator.key()))
+                iterator.previous()
+            }
+        }
+        Assert.assertEquals(keys.reversed(), backward)
+
+        // Changing direction in the middle.
+        db.iterator().use { iterator ->
+            iterator.seek("key0250".toByteArray())
+            Assert.assertEquals("key0250", String(iterator.key()))
+            iterator.next()
+            iterator.next()
+            Assert.assertEquals("key0252", String(iterator.key()))
+            iterator.previous()
+            Assert.assertEquals("key0251", String(iterator.key()))
+            iterator.previous()
+            iterator.previous()
+            Assert.assertEquals("key0249", String(iterator.key()))
+            iterator.next()
+            Assert.assertEquals("key0250", String(iterator.key()))
+        }
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testBatchAndGetAll() {
+        val db = obtainLevelDB() as ShardedLevelDB
+        db.put("gone", "soon")
+
+        val batch = SimpleWriteBatch(db)
+        for (i in 0 until 100) {
+            batch.put("key$i", "value$i")
+        }
+        batch.del("gone")
+        db.write(batch)
+
+        val keys = (0 until 100).map { "key$it".toByteArray() } + "gone".toByteArray()
+        val values = db.getAll(keys)
+        for (i in 0 until 100) {
+            Assert.assertEquals("value$i", String(values[i]!!))
+        }
+        Assert.assertNull(values[100])
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testSnapshotAcrossShards() {
+        val db = obtainLevelDB() as ShardedLevelDB
+        for (i in 0 until 100) {
+            db.put("key$i", "old")
+        }
+
+        val snapshot = db.obtainSnapshot()
+        val batch = SimpleWriteBatch(db)
+        for (i in 0 until 100) {
+            batch.put("key$i", "new")
+        }
+        db.write(batch)
+
+        val keys = (0 until 100).map { "key$it".toByteArray() }
+        Assert.assertTrue(db.getAll(keys, snapshot).all { String(it!!) == "old" })
+        Assert.assertTrue(db.getAll(keys).all { String(it!!) == "new" })
+
+        var count = 0
+        db.iterator(snapshot).use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                Assert.assertEquals("old", String(iterator.value()))
+                count++
+                iterator.next()
+            }
+        }
+        Assert.assertEquals(100, count)
+
+        db.releaseSnapshot(snapshot)
+        Assert.assertTrue(snapshot.isReleased)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testRangeRouting() {
+        val router = ShardRouter.range("g".toByteArray(), "p".toByteArray())
+        Assert.assertEquals(3, router.shards)
+        Assert.assertEquals(0, router.shardOf("apple".toByteArray()))
+        Assert.assertEquals(1, router.shardOf("g".toByteArray()))
+        Assert.assertEquals(1, router.shardOf("kiwi".toByteArray()))
+        Assert.assertEquals(2, router.shardOf("plum".toByteArray()))
+
+        val db = ShardedLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true), router)
+        listOf("plum", "apple", "kiwi").forEach { db.put(it, it) }
+        Assert.assertEquals("kiwi", db.shard(1).getString("kiwi"))
+
+        val keys = ArrayList<String>()
+        db.iterator().use { iterator ->
+            iterator.seekToFirst()
+            while (iterator.isValid) {
+                keys.add(String(iterator.key()))
+                iterator.next()
+            }
+        }
+        Assert.assertEquals(listOf("apple", "kiwi", "plum"), keys)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReopenWithOtherShardCount() {
+        obtainLevelDB().close()
+
+        try {
+            ShardedLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true), 2)
+            Assert.fail("Opening with a different shard count should fail")
+        } catch (e: LevelDBException) {
+            // expected
+        }
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testInMemory() {
+        val db = ShardedLevelDB(LevelDB.IN_MEMORY_PATH, LevelDB.Config(), 4)
+        db.put("key", "value")
+        Assert.assertEquals("value", db.getString("key"))
+        Assert.assertTrue(db.shard(0).isInMemory)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testReadsWithoutSnapshotSeeWholeBatches() {
+        val db = obtainLevelDB() as ShardedLevelDB
+        val keys = (0 until 32).map { "key$it" }
+
+        // Every batch sets all keys, which are spread over all shards, to the same value.
+        val writer = Thread {
+            for (round in 0 until 500) {
+                val batch = SimpleWriteBatch(db)
+                keys.forEach { batch.put(it, "round$round") }
+                batch.commit()
+            }
+        }
+        SimpleWriteBatch(db).apply { keys.forEach { put(it, "initial") } }.commit()
+        writer.start()
+
+        while (writer.isAlive) {
+            val values = HashSet<String>()
+            db.iterator().use { iterator ->
+                iterator.seekToFirst()
+                while (iterator.isValid) {
+                    values.add(String(iterator.value()))
+                    iterator.next()
+                }
+            }
+            Assert.assertEquals(1, values.size)
+
+            val all = db.getAll(keys.map { it.toByteArray() }).map { String(it!!) }
+            Assert.assertEquals(1, all.toSet().size)
+        }
+
+        writer.join()
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return ShardedLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true), 4)
+    }
+}
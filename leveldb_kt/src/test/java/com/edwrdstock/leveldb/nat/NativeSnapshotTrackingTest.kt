@@ -0,0 +1,113 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.SnapshotLeak
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.util.concurrent.CopyOnWriteArrayList
+
+class NativeSnapshotTrackingTest : DatabaseTestCase() {
+
+    private val leaks = CopyOnWriteArrayList<SnapshotLeak>()
+
+    @Test
+    @Throws(Exception::class)
+    fun testStats() {
+        val db = obtainLevelDB() as NativeLevelDB
+
+        var stats = db.snapshotStats()
+        Assert.assertEquals(0L, stats.count)
+        Assert.assertEquals(0L, stats.oldestAgeMillis)
+
+        db.put("a", "1")
+        val first = db.obtainSnapshot()
+        db.put("b", "2")
+        db.put("c", "3")
+        val second = db.obtainSnapshot()
+        Thread.sleep(20)
+
+        stats = db.snapshotStats()
+        Assert.assertEquals(2L, stats.count)
+        Assert.assertEquals(1L, stats.oldestSequence)
+        Assert.assertTrue(stats.oldestAgeMillis >= 20)
+
+        db.releaseSnapshot(first)
+        stats = db.snapshotStats()
+        Assert.assertEquals(1L, stats.count)
+        Assert.assertEquals(3L, stats.oldestSequence)
+
+        db.releaseSnapshot(second)
+        Assert.assertEquals(0L, db.snapshotStats().count)
+
+        db.close()
+        Assert.assertTrue(leaks.isEmpty())
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testExpiry() {
+        val db = NativeLevelDB(
+            dbFile.absolutePath,
+            config().apply { snapshotMaxAge = 50 }
+        )
+        db.put("key", "value")
+
+        val snapshot = db.obtainSnapshot()
+        // The leak is reported last, once the snapshot is released.
+        val deadline = System.currentTimeMillis() + 10_000
+        while (leaks.isEmpty() || db.snapshotStats().count != 0L) {
+            Assert.assertTrue("Snapshot not expired in time", System.currentTimeMillis() < deadline)
+            Thread.sleep(10)
+        }
+
+        Assert.assertTrue(snapshot.isReleased)
+        try {
+            db.get("key".toByteArray(), snapshot)
+            Assert.fail("Snapshot should have expired")
+        } catch (e: LevelDBClosedException) {
+            // expected
+        }
+
+        val stats = db.snapshotStats()
+        Assert.assertEquals(0L, stats.count)
+        Assert.assertEquals(1L, stats.expired)
+
+        Assert.assertEquals(1, leaks.size)
+        Assert.assertTrue(leaks[0].expired)
+        Assert.assertTrue(leaks[0].ageMillis >= 50)
+        Assert.assertNotNull(leaks[0].origin)
+
+        // Releasing it later is fine.
+        db.releaseSnapshot(snapshot)
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testLeakOnClose() {
+        val db = obtainLevelDB()
+        db.obtainSnapshot()
+        db.close()
+
+        Assert.assertEquals(1, leaks.size)
+        Assert.assertFalse(leaks[0].expired)
+        val origin = leaks[0].origin!!
+        Assert.assertTrue(origin.stackTrace.any { it.methodName == "testLeakOnClose" })
+    }
+
+    private fun config(): LevelDB.Config {
+        return LevelDB.Config(
+            createIfMissing = true,
+            snapshotLeakDetection = true,
+            snapshotLeakListener = { leaks.add(it) }
+        )
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, config())
+    }
+}
@@ -0,0 +1,119 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.exception.LevelDBClosedException
+import com.edwardstock.leveldb.exception.LevelDBTransactionConflictException
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+
+class NativeTransactionTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testCommitAndReadOwnWrites() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("a", "1")
+
+        val tx = db.beginTransaction()
+        Assert.assertEquals(1L, db.snapshotStats().count)
+        Assert.assertEquals("1", String(tx["a"]!!))
+        tx.put("a", "2")
+        tx.put("b", "3")
+        tx.del("c")
+        Assert.assertEquals("2", String(tx["a"]!!))
+        Assert.assertNull(tx["c"])
+
+        // Buffered until commit
+        Assert.assertEquals("1", db.getString("a"))
+        Assert.assertNull(db.getString("b"))
+
+        tx.commit()
+        Assert.assertTrue(tx.isClosed)
+        Assert.assertEquals(0L, db.snapshotStats().count)
+        Assert.assertEquals("2", db.getString("a"))
+        Assert.assertEquals("3", db.getString("b"))
+
+        val rolledBack = db.beginTransaction()
+        rolledBack.put("a", "4")
+        rolledBack.rollback()
+        Assert.assertEquals("2", db.getString("a"))
+
+        var threw = false
+        try {
+            rolledBack.put("a", "5")
+        } catch (e: LevelDBClosedException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testConflict() {
+        val db = obtainLevelDB() as NativeLevelDB
+        db.put("counter", "1")
+
+        val first = db.beginTransaction()
+        val second = db.beginTransaction()
+        first.put("counter", String(first["counter"]!!) + "1")
+        second.put("counter", String(second["counter"]!!) + "2")
+
+        first.commit()
+
+        var threw = false
+        try {
+            second.commit()
+        } catch (e: LevelDBTransactionConflictException) {
+            threw = true
+        }
+        Assert.assertTrue(threw)
+        Assert.assertEquals("11", db.getString("counter"))
+
+        // Blind writes don't conflict
+        val blind = db.beginTransaction()
+        db.put("counter", "3")
+        blind.put("other", "x")
+        blind.commit()
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testConcurrentIncrements() {
+        val db = obtainLevelDB() as NativeLevelDB
+        val key = "counter".toByteArray()
+        db.put(key, ByteBuffer.allocate(8).putLong(0).array())
+
+        val threads = 8
+        val increments = 200
+        val pool = Executors.newFixedThreadPool(threads)
+        repeat(threads) {
+            pool.execute {
+                repeat(increments) {
+                    db.inTransaction(maxAttempts = Int.MAX_VALUE) {
+                        val value = ByteBuffer.wrap(get(key)!!).long
+                        put(key, ByteBuffer.allocate(8).putLong(value + 1).array())
+                    }
+                }
+            }
+        }
+        pool.shutdown()
+        Assert.assertTrue(pool.awaitTermination(1, TimeUnit.MINUTES))
+
+        Assert.assertEquals((threads * increments).toLong(), ByteBuffer.wrap(db[key]!!).long)
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(dbFile.absolutePath, LevelDB.Config(createIfMissing = true))
+    }
+}
@@ -0,0 +1,86 @@
+package com.edwrdstock.leveldb.nat
+
+import com.edwardstock.leveldb.LevelDB
+import com.edwardstock.leveldb.implementation.NativeLevelDB
+import com.edwardstock.leveldb.implementation.SimpleWriteBatch
+import com.edwrdstock.leveldb.common.DatabaseTestCase
+import org.junit.Assert
+import org.junit.Test
+import java.util.concurrent.atomic.AtomicBoolean
+
+class NativeWritePressureTest : DatabaseTestCase() {
+
+    @Test
+    @Throws(Exception::class)
+    fun testTryWrites() {
+        val db = obtainLevelDB() as NativeLevelDB
+
+        var pressure = db.writePressure()
+        Assert.assertEquals(0, pressure.l0Files)
+        Assert.assertEquals(0, pressure.stalledWriters)
+        Assert.assertEquals(0L, pressure.stalls)
+
+        Assert.assertEquals(0L, db.tryPut("key", "value"))
+        Assert.assertEquals("value", db.getString("key"))
+
+        Assert.assertEquals(0L, db.tryWrite(SimpleWriteBatch(db).put("a", "1").del("key")))
+        Assert.assertEquals("1", db.getString("a"))
+        Assert.assertNull(db.getString("key"))
+
+        db.close()
+    }
+
+    @Test
+    @Throws(Exception::class)
+    fun testPressureUnderLoad() {
+        val db = obtainLevelDB() as NativeLevelDB
+        val value = ByteArray(1024) { it.toByte() }
+
+        // Writers that wait for leveldb fill level 0 faster than it's compacted.
+        val done = AtomicBoolean(false)
+        val writers = (0 until 4).map { writer ->
+            Thread {
+                var i = 0
+                while (!done.get()) {
+                    db.put("writer$writer-${i++}".toByteArray(), value)
+                }
+            }.apply { start() }
+        }
+
+        var hint = 0L
+        var i = 0
+        var maxStalled = 0
+        val deadline = System.currentTimeMillis() + 30000
+        while (hint == 0L && System.currentTimeMillis() < deadline) {
+            val key = "try${i++}".toByteArray()
+            hint = db.tryPut(key, value)
+            if (hint != 0L) {
+                Assert.assertNull(db[key])
+            }
+            maxStalled = maxOf(maxStalled, db.writePressure().stalledWriters)
+        }
+
+        done.set(true)
+        writers.forEach { it.join() }
+
+        Assert.assertTrue(hint > 0)
+        // The writers queued behind a stalled group commit leader count too.
+        Assert.assertTrue(maxStalled <= writers.size)
+        val pressure = db.writePressure()
+        Assert.assertEquals(0, pressure.stalledWriters)
+        Assert.assertTrue(pressure.l0Files >= 0)
+        if (pressure.throttledWrites > 0) {
+            Assert.assertTrue(pressure.throttleMicros > 0)
+        }
+
+        db.close()
+    }
+
+    @Throws(Exception::class)
+    override fun obtainLevelDB(): LevelDB {
+        return NativeLevelDB(
+            dbFile.absolutePath,
+            LevelDB.Config(createIfMissing = true, writeBufferSize = 64 * 1024, throttleWrites = true)
+        )
+    }
+}
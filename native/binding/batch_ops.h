@@ -0,0 +1,40 @@
+#ifndef LEVELDB_ANDROID_BATCH_OPS_H
+#define LEVELDB_ANDROID_BATCH_OPS_H
+
+#include <vector>
+
+#include "leveldb/write_batch.h"
+#include "key_locks.h"
+
+// Records of a WriteBatch, in order. Slices point into the batch itself, so
+// the batch must outlive this object.
+class BatchOps final: public leveldb::WriteBatch::Handler {
+ public:
+  struct Op {
+    bool put;
+    leveldb::Slice key;
+    leveldb::Slice value;
+  };
+
+  void Put(const leveldb::Slice &key, const leveldb::Slice &value) override {
+    ops.push_back({true, key, value});
+  }
+
+  void Delete(const leveldb::Slice &key) override {
+    ops.push_back({false, key, leveldb::Slice()});
+  }
+
+  // Lock stripes of all keys in the batch.
+  std::vector<size_t> Stripes() const {
+    std::vector<size_t> stripes;
+    stripes.reserve(ops.size());
+    for (const Op &op: ops) {
+      stripes.push_back(KeyLocks::StripeOf(op.key));
+    }
+    return stripes;
+  }
+
+  std::vector<Op> ops;
+};
+
+#endif //LEVELDB_ANDROID_BATCH_OPS_H
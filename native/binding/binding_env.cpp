@@ -0,0 +1,260 @@
+#include "binding_env.h"
+
+#include <utility>
+
+#include "helpers/memenv/memenv.h"
+#include "readahead.h"
+#include "util/coding.h"
+
+namespace {
+
+struct ScheduledWork {
+  BindingEnv *env;
+  void (*function)(void *arg);
+  void *arg;
+};
+
+// Env whose background work runs on the current thread, if any.
+thread_local const BindingEnv *backgroundEnv = nullptr;
+
+void RunScheduled(void *arg) {
+  std::unique_ptr<ScheduledWork> work((ScheduledWork *) arg);
+
+  const BindingEnv *previous = backgroundEnv;
+  backgroundEnv = work->env;
+
+  if (work->env->Readahead() != 0) {
+    // Background work is compaction, which reads its input tables sequentially.
+    ReadaheadWindows windows;
+    ScanScope scope(&windows);
+    work->function(work->arg);
+  } else {
+    work->function(work->arg);
+  }
+
+  backgroundEnv = previous;
+}
+
+bool IsTable(const std::string &fname) {
+  size_t length = fname.size();
+  return length > 4 && (fname.compare(length - 4, 4, ".ldb") == 0 || fname.compare(length - 4, 4, ".sst") == 0);
+}
+
+// Counts the bytes appended to a file of an in-memory env.
+class CountingFile final: public leveldb::WritableFile {
+ public:
+  CountingFile(leveldb::WritableFile *base, std::atomic<uint64_t> *usage) : base_(base), usage_(usage) {}
+
+  leveldb::Status Append(const leveldb::Slice &data) override {
+    leveldb::Status status = base_->Append(data);
+    if (status.ok()) {
+      usage_->fetch_add(data.size(), std::memory_order_relaxed);
+    }
+    return status;
+  }
+
+  leveldb::Status Close() override {
+    return base_->Close();
+  }
+
+  leveldb::Status Flush() override {
+    return base_->Flush();
+  }
+
+  leveldb::Status Sync() override {
+    return base_->Sync();
+  }
+
+ private:
+  std::unique_ptr<leveldb::WritableFile> base_;
+  std::atomic<uint64_t> *usage_;
+};
+
+// Counts the bytes the background work of `env` reads from a table.
+class BackgroundReadCountingFile final: public leveldb::RandomAccessFile {
+ public:
+  BackgroundReadCountingFile(leveldb::RandomAccessFile *base, BindingEnv *env) : base_(base), env_(env) {}
+
+  leveldb::Status Read(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const override {
+    leveldb::Status status = base_->Read(offset, n, result, scratch);
+    if (status.ok() && env_->InBackground()) {
+      env_->RecordBackgroundRead(result->size());
+    }
+    return status;
+  }
+
+ private:
+  std::unique_ptr<leveldb::RandomAccessFile> base_;
+  BindingEnv *env_;
+};
+
+// Keeps the size of the index block of an open table in `usage`. leveldb
+// holds the index of every table in its table cache in memory; it opens the
+// file only to read the table, and reads the footer that locates the index
+// first.
+class IndexTrackingFile final: public leveldb::RandomAccessFile {
+ public:
+  IndexTrackingFile(leveldb::RandomAccessFile *base, std::atomic<uint64_t> *usage) : base_(base), usage_(usage) {}
+
+  ~IndexTrackingFile() override {
+    usage_->fetch_sub(indexSize_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+  leveldb::Status Read(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const override {
+    leveldb::Status status = base_->Read(offset, n, result, scratch);
+    if (status.ok() && !footerRead_.exchange(true, std::memory_order_relaxed)) {
+      uint64_t size = IndexSize(*result);
+      indexSize_.store(size, std::memory_order_relaxed);
+      usage_->fetch_add(size, std::memory_order_relaxed);
+    }
+    return status;
+  }
+
+ private:
+  // Footer: metaindex and index block handles (varint64 offset and size
+  // each), padding and the 8 byte magic number.
+  static const size_t kFooterSize = 48;
+  static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
+  // Type and crc32c following every block.
+  static const size_t kBlockTrailerSize = 5;
+
+  static uint64_t IndexSize(const leveldb::Slice &footer) {
+    if (footer.size() != kFooterSize || leveldb::DecodeFixed64(footer.data() + kFooterSize - 8) != kTableMagicNumber) {
+      return 0;
+    }
+
+    leveldb::Slice input = footer;
+    uint64_t metaindexOffset, metaindexSize, indexOffset, indexSize;
+    if (!leveldb::GetVarint64(&input, &metaindexOffset) || !leveldb::GetVarint64(&input, &metaindexSize)
+        || !leveldb::GetVarint64(&input, &indexOffset) || !leveldb::GetVarint64(&input, &indexSize)) {
+      return 0;
+    }
+    return indexSize + kBlockTrailerSize;
+  }
+
+  std::unique_ptr<leveldb::RandomAccessFile> base_;
+  std::atomic<uint64_t> *usage_;
+  mutable std::atomic<bool> footerRead_{false};
+  mutable std::atomic<uint64_t> indexSize_{0};
+};
+
+} // namespace
+
+BindingEnv::BindingEnv(std::unique_ptr<leveldb::Env> memory, uint64_t memoryLimit)
+    : leveldb::EnvWrapper(memory.get()), readahead_(0), memory_(std::move(memory)), memoryLimit_(memoryLimit) {}
+
+BindingEnv *BindingEnv::NewInMemory(uint64_t memoryLimit) {
+  return new BindingEnv(std::unique_ptr<leveldb::Env>(leveldb::NewMemEnv(leveldb::Env::Default())), memoryLimit);
+}
+
+leveldb::Status BindingEnv::NewRandomAccessFile(const std::string &fname, leveldb::RandomAccessFile **result) {
+  if (!IsTable(fname)) {
+    return target()->NewRandomAccessFile(fname, result);
+  }
+
+  leveldb::Status status = readahead_ == 0
+                           ? target()->NewRandomAccessFile(fname, result)
+                           : NewReadaheadFile(fname, readahead_, &readaheadBytesRead_, &readaheadWindowBytes_, result);
+
+  if (status.ok() && countBackgroundReads_) {
+    *result = new BackgroundReadCountingFile(*result, this);
+  }
+  if (status.ok()) {
+    *result = new IndexTrackingFile(*result, &tableIndexBytes_);
+  }
+  return status;
+}
+
+leveldb::Status BindingEnv::NewWritableFile(const std::string &fname, leveldb::WritableFile **result) {
+  if (!InMemory()) {
+    return target()->NewWritableFile(fname, result);
+  }
+
+  // An existing file is truncated.
+  Release(fname);
+
+  leveldb::Status status = target()->NewWritableFile(fname, result);
+  if (status.ok()) {
+    *result = new CountingFile(*result, &memoryUsage_);
+  }
+  return status;
+}
+
+leveldb::Status BindingEnv::NewAppendableFile(const std::string &fname, leveldb::WritableFile **result) {
+  leveldb::Status status = target()->NewAppendableFile(fname, result);
+  if (status.ok() && InMemory()) {
+    *result = new CountingFile(*result, &memoryUsage_);
+  }
+  return status;
+}
+
+leveldb::Status BindingEnv::RenameFile(const std::string &src, const std::string &target) {
+  if (InMemory()) {
+    // An existing target is replaced.
+    Release(target);
+  }
+
+  return this->target()->RenameFile(src, target);
+}
+
+void BindingEnv::Schedule(void (*function)(void *arg), void *arg) {
+  if (readahead_ == 0 && !countBackgroundReads_) {
+    target()->Schedule(function, arg);
+    return;
+  }
+
+  target()->Schedule(&RunScheduled, new ScheduledWork{this, function, arg});
+}
+
+bool BindingEnv::InBackground() const {
+  return backgroundEnv == this;
+}
+
+leveldb::Status BindingEnv::RemoveFile(const std::string &fname) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pauses_ > 0) {
+      deferred_.push_back(fname);
+      return leveldb::Status::OK();
+    }
+  }
+
+  return RemoveNow(fname);
+}
+
+void BindingEnv::PauseDeletions() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pauses_++;
+}
+
+void BindingEnv::ResumeDeletions() {
+  std::vector<std::string> deferred;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pauses_ > 0) {
+      return;
+    }
+    deferred.swap(deferred_);
+  }
+
+  // File numbers are never reused, so none of these has been re-created
+  // meanwhile. Failures are ignored, as leveldb does for obsolete files.
+  for (const std::string &fname: deferred) {
+    RemoveNow(fname);
+  }
+}
+
+leveldb::Status BindingEnv::RemoveNow(const std::string &fname) {
+  if (InMemory()) {
+    Release(fname);
+  }
+
+  return target()->RemoveFile(fname);
+}
+
+void BindingEnv::Release(const std::string &fname) {
+  uint64_t size;
+  if (target()->GetFileSize(fname, &size).ok()) {
+    memoryUsage_.fetch_sub(size, std::memory_order_relaxed);
+  }
+}
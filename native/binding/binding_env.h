@@ -0,0 +1,138 @@
+#ifndef LEVELDB_ANDROID_BINDING_ENV_H
+#define LEVELDB_ANDROID_BINDING_ENV_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+
+// Env of a database opened by the binding. Forwards everything to the target
+// env, but lets the binding hold back file deletions while it copies files
+// out of the database directory, and read tables with readahead. Also
+// tracks how much memory the indexes of open tables take.
+//
+// In-memory databases run on an env of their own, which also counts the
+// bytes their files take.
+class BindingEnv final: public leveldb::EnvWrapper {
+ public:
+  // Non-zero `readahead` opens tables with NewReadaheadFile() and runs
+  // compactions in a ScanScope of their own. Requires a target env on the filesystem.
+  explicit BindingEnv(leveldb::Env *target, size_t readahead = 0)
+      : leveldb::EnvWrapper(target), readahead_(readahead) {}
+
+  // Env keeping all files in memory, on top of leveldb's NewMemEnv(). Zero
+  // `memoryLimit` means no limit.
+  static BindingEnv *NewInMemory(uint64_t memoryLimit);
+
+  leveldb::Status NewRandomAccessFile(const std::string &fname, leveldb::RandomAccessFile **result) override;
+  leveldb::Status NewWritableFile(const std::string &fname, leveldb::WritableFile **result) override;
+  leveldb::Status NewAppendableFile(const std::string &fname, leveldb::WritableFile **result) override;
+  leveldb::Status RenameFile(const std::string &src, const std::string &target) override;
+
+  void Schedule(void (*function)(void *arg), void *arg) override;
+
+  size_t Readahead() const {
+    return readahead_;
+  }
+
+  // Makes the env count the bytes read from tables by its background work,
+  // i.e. by compactions. Must be called before the database is opened.
+  void CountBackgroundReads() {
+    countBackgroundReads_ = true;
+  }
+
+  uint64_t BackgroundBytesRead() const {
+    return backgroundBytesRead_.load(std::memory_order_relaxed);
+  }
+
+  void RecordBackgroundRead(size_t bytes) {
+    backgroundBytesRead_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Bytes of the index blocks of the tables open right now, which leveldb
+  // keeps in memory while the tables are in its table cache.
+  uint64_t TableIndexBytes() const {
+    return tableIndexBytes_.load(std::memory_order_relaxed);
+  }
+
+  // Bytes read from disk by the tables opened with NewReadaheadFile().
+  uint64_t ReadaheadBytesRead() const {
+    return readaheadBytesRead_.load(std::memory_order_relaxed);
+  }
+
+  // Bytes of the readahead windows scans and compactions hold right now.
+  uint64_t ReadaheadWindowBytes() const {
+    return readaheadWindowBytes_.load(std::memory_order_relaxed);
+  }
+
+  // Whether the current thread runs background work of this env.
+  bool InBackground() const;
+
+  // While deletions are paused, removed files are only remembered, and
+  // actually removed when the last pause ends.
+  leveldb::Status RemoveFile(const std::string &fname) override;
+
+  void PauseDeletions();
+  void ResumeDeletions();
+
+  bool InMemory() const {
+    return memory_ != nullptr;
+  }
+
+  // Bytes taken by the files of an in-memory env, zero for other envs.
+  uint64_t MemoryUsage() const {
+    return memoryUsage_.load(std::memory_order_relaxed);
+  }
+
+  // Whether `size` more bytes would take an in-memory env over its limit.
+  // Only writes through the binding check it: compactions must never fail,
+  // so the files may temporarily outgrow the limit while they run.
+  bool OverMemoryLimit(uint64_t size) const {
+    return memoryLimit_ != 0 && MemoryUsage() + size > memoryLimit_;
+  }
+
+  class DeletionPause {
+   public:
+    explicit DeletionPause(BindingEnv *env) : env_(env) {
+      env_->PauseDeletions();
+    }
+
+    ~DeletionPause() {
+      env_->ResumeDeletions();
+    }
+
+    DeletionPause(const DeletionPause &) = delete;
+    DeletionPause &operator=(const DeletionPause &) = delete;
+
+   private:
+    BindingEnv *env_;
+  };
+
+ private:
+  BindingEnv(std::unique_ptr<leveldb::Env> memory, uint64_t memoryLimit);
+
+  leveldb::Status RemoveNow(const std::string &fname);
+  void Release(const std::string &fname);
+
+  const size_t readahead_;
+  bool countBackgroundReads_ = false;
+  std::atomic<uint64_t> backgroundBytesRead_{0};
+  std::atomic<uint64_t> tableIndexBytes_{0};
+  std::atomic<uint64_t> readaheadBytesRead_{0};
+  std::atomic<uint64_t> readaheadWindowBytes_{0};
+
+  // Target of in-memory envs, owned.
+  std::unique_ptr<leveldb::Env> memory_;
+  const uint64_t memoryLimit_ = 0;
+  std::atomic<uint64_t> memoryUsage_{0};
+
+  std::mutex mutex_;
+  int pauses_ = 0;
+  std::vector<std::string> deferred_;
+};
+
+#endif //LEVELDB_ANDROID_BINDING_ENV_H
@@ -0,0 +1,74 @@
+#include "change_feed.h"
+
+namespace {
+
+// Limits a single read, so a far behind consumer gets its backlog in parts.
+const size_t kMaxReadSize = 4 * 1024 * 1024;
+
+void PutFixed32BE(std::string *out, uint32_t value) {
+  out->push_back((char) (value >> 24));
+  out->push_back((char) (value >> 16));
+  out->push_back((char) (value >> 8));
+  out->push_back((char) value);
+}
+
+void PutFixed64BE(std::string *out, uint64_t value) {
+  PutFixed32BE(out, (uint32_t) (value >> 32));
+  PutFixed32BE(out, (uint32_t) value);
+}
+
+} // namespace
+
+uint64_t ChangeFeed::Append(std::atomic<uint64_t> *sequence, const BatchOps &ops) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint64_t last = sequence->fetch_add(ops.ops.size(), std::memory_order_acq_rel) + ops.ops.size();
+
+  // Sequences are contiguous, the first record always matches firstSequence_ + records_.size().
+  for (const BatchOps::Op &op: ops.ops) {
+    Record record;
+    record.put = op.put;
+    record.key = op.key.ToString();
+    if (op.put) {
+      record.value = op.value.ToString();
+    }
+
+    size_ += SizeOf(record);
+    records_.push_back(std::move(record));
+  }
+
+  while (size_ > capacity_ && !records_.empty()) {
+    size_ -= SizeOf(records_.front());
+    records_.pop_front();
+    firstSequence_++;
+  }
+
+  return last;
+}
+
+bool ChangeFeed::Read(uint64_t afterSequence, size_t maxRecords, std::string *out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (afterSequence + 1 < firstSequence_) {
+    return false;
+  }
+
+  size_t index = (size_t) (afterSequence + 1 - firstSequence_);
+
+  for (size_t read = 0; index < records_.size() && read < maxRecords; index++, read++) {
+    const Record &record = records_[index];
+
+    if (read > 0 && out->size() + SizeOf(record) > kMaxReadSize) {
+      break;
+    }
+
+    PutFixed64BE(out, firstSequence_ + index);
+    out->push_back(record.put ? 1 : 0);
+    PutFixed32BE(out, (uint32_t) record.key.size());
+    out->append(record.key);
+    PutFixed32BE(out, (uint32_t) record.value.size());
+    out->append(record.value);
+  }
+
+  return true;
+}
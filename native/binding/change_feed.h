@@ -0,0 +1,58 @@
+#ifndef LEVELDB_ANDROID_CHANGE_FEED_H
+#define LEVELDB_ANDROID_CHANGE_FEED_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "batch_ops.h"
+
+// In-memory feed of the last writes, bounded by their total size. Every
+// record gets the sequence of the binding write that produced it, so a
+// consumer can resume from the last sequence it has seen as long as that
+// record hasn't been evicted yet.
+class ChangeFeed {
+ public:
+  explicit ChangeFeed(size_t capacity) : capacity_(capacity) {}
+
+  bool Enabled() const {
+    return capacity_ != 0;
+  }
+
+  // Assigns the next sequences of `sequence` to `ops`, in order, and keeps
+  // the records. Returns the sequence of the last one. Sequences are assigned
+  // under the feed's lock, so the feed is always ordered by sequence.
+  uint64_t Append(std::atomic<uint64_t> *sequence, const BatchOps &ops);
+
+  // Encodes up to `maxRecords` records following `afterSequence` into `out`:
+  // big-endian sequence (8 bytes), op (1 byte, 1 = put, 0 = delete), key
+  // length (4 bytes), key, value length (4 bytes), value.
+  // Returns false if records following `afterSequence` have been evicted.
+  bool Read(uint64_t afterSequence, size_t maxRecords, std::string *out) const;
+
+ private:
+  struct Record {
+    bool put;
+    std::string key;
+    std::string value;
+  };
+
+  // Bookkeeping size of a record, on top of its key and value.
+  static const size_t kRecordOverhead = sizeof(Record);
+
+  static size_t SizeOf(const Record &record) {
+    return kRecordOverhead + record.key.size() + record.value.size();
+  }
+
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::deque<Record> records_;
+  // Sequence of records_.front(), or of the next record when empty.
+  uint64_t firstSequence_ = 1;
+  size_t size_ = 0;
+};
+
+#endif //LEVELDB_ANDROID_CHANGE_FEED_H
@@ -0,0 +1,427 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "leveldb/slice.h"
+#include "db/log_reader.h"
+#include "util/coding.h"
+
+namespace {
+
+const size_t kCopyBufferSize = 64 * 1024;
+
+bool EndsWith(const std::string &name, const char *suffix) {
+  size_t length = strlen(suffix);
+  return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+bool IsTable(const std::string &name) {
+  return EndsWith(name, ".ldb") || EndsWith(name, ".sst");
+}
+
+bool IsLog(const std::string &name) {
+  return EndsWith(name, ".log");
+}
+
+leveldb::Status WriteFileSync(leveldb::Env *env, const std::string &fname, const leveldb::Slice &data) {
+  leveldb::WritableFile *file;
+  leveldb::Status status = env->NewWritableFile(fname, &file);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::unique_ptr<leveldb::WritableFile> guard(file);
+  status = file->Append(data);
+  if (status.ok()) {
+    status = file->Sync();
+  }
+  if (status.ok()) {
+    status = file->Close();
+  }
+
+  return status;
+}
+
+// Hard-links `src` to `dst`, both on the same filesystem.
+bool LinkFile(const std::string &src, const std::string &dst) {
+#ifndef _WIN32
+  return ::link(src.c_str(), dst.c_str()) == 0;
+#else
+  // Copied instead.
+  return false;
+#endif
+}
+
+// Removes `dir` and everything in it, if it exists.
+void RemoveDirectory(leveldb::Env *env, const std::string &dir) {
+  std::vector<std::string> children;
+  if (!env->GetChildren(dir, &children).ok()) {
+    return;
+  }
+
+  for (const std::string &child: children) {
+    if (child == "." || child == "..") {
+      continue;
+    }
+    std::string path = dir + "/" + child;
+    if (!env->RemoveFile(path).ok()) {
+      RemoveDirectory(env, path);
+    }
+  }
+  env->RemoveDir(dir);
+}
+
+// Tags of the fields of leveldb's VersionEdit, see db/version_edit.cc.
+enum EditTag {
+  kComparator = 1,
+  kLogNumber = 2,
+  kNextFileNumber = 3,
+  kLastSequence = 4,
+  kCompactPointer = 5,
+  kDeletedFile = 6,
+  kNewFile = 7,
+  kPrevLogNumber = 9,
+};
+
+// Reads a string as a file.
+class StringFile final: public leveldb::SequentialFile {
+ public:
+  explicit StringFile(const std::string &data) : data_(data) {}
+
+  leveldb::Status Read(size_t n, leveldb::Slice *result, char *scratch) override {
+    n = std::min(n, data_.size() - offset_);
+    *result = leveldb::Slice(data_.data() + offset_, n);
+    offset_ += n;
+    return leveldb::Status::OK();
+  }
+
+  leveldb::Status Skip(uint64_t n) override {
+    offset_ += (size_t) std::min<uint64_t>(n, data_.size() - offset_);
+    return leveldb::Status::OK();
+  }
+
+ private:
+  const std::string &data_;
+  size_t offset_ = 0;
+};
+
+class CorruptionReporter final: public leveldb::log::Reader::Reporter {
+ public:
+  void Corruption(size_t bytes, const leveldb::Status &status) override {
+    if (status_.ok()) {
+      status_ = status;
+    }
+  }
+
+  const leveldb::Status &status() const {
+    return status_;
+  }
+
+ private:
+  leveldb::Status status_;
+};
+
+// Replays the edits of `manifest`, the contents of a MANIFEST, and collects
+// the numbers of the tables of the version they lead to.
+leveldb::Status LiveTables(const std::string &manifest, std::set<uint64_t> *tables) {
+  StringFile file(manifest);
+  CorruptionReporter reporter;
+  leveldb::log::Reader reader(&file, &reporter, true, 0);
+
+  // Level and number of every live table.
+  std::set<std::pair<uint32_t, uint64_t>> live;
+  leveldb::Slice record;
+  std::string scratch;
+
+  while (reader.ReadRecord(&record, &scratch) && reporter.status().ok()) {
+    std::vector<std::pair<uint32_t, uint64_t>> added;
+    leveldb::Slice input = record;
+    leveldb::Slice slice;
+    uint32_t tag, level;
+    uint64_t number, value;
+    bool ok = true;
+
+    while (ok && !input.empty()) {
+      ok = leveldb::GetVarint32(&input, &tag);
+      if (!ok) {
+        break;
+      }
+
+      switch (tag) {
+        case kComparator:
+          ok = leveldb::GetLengthPrefixedSlice(&input, &slice);
+          break;
+        case kLogNumber:
+        case kNextFileNumber:
+        case kLastSequence:
+        case kPrevLogNumber:
+          ok = leveldb::GetVarint64(&input, &value);
+          break;
+        case kCompactPointer:
+          ok = leveldb::GetVarint32(&input, &level) && leveldb::GetLengthPrefixedSlice(&input, &slice);
+          break;
+        case kDeletedFile:
+          ok = leveldb::GetVarint32(&input, &level) && leveldb::GetVarint64(&input, &number);
+          if (ok) {
+            live.erase(std::make_pair(level, number));
+          }
+          break;
+        case kNewFile:
+          ok = leveldb::GetVarint32(&input, &level) && leveldb::GetVarint64(&input, &number)
+              && leveldb::GetVarint64(&input, &value) && leveldb::GetLengthPrefixedSlice(&input, &slice)
+              && leveldb::GetLengthPrefixedSlice(&input, &slice);
+          if (ok) {
+            added.emplace_back(level, number);
+          }
+          break;
+        default:
+          ok = false;
+      }
+    }
+
+    if (!ok) {
+      return leveldb::Status::Corruption("MANIFEST holds an edit that can't be decoded");
+    }
+
+    // leveldb applies the deletions of an edit first: a table moved to the
+    // next level is deleted from one and added to the other.
+    live.insert(added.begin(), added.end());
+  }
+
+  if (!reporter.status().ok()) {
+    return reporter.status();
+  }
+
+  tables->clear();
+  for (const auto &table: live) {
+    tables->insert(table.second);
+  }
+  return leveldb::Status::OK();
+}
+
+// Number of a table file, e.g. 5 for "000005.ldb".
+uint64_t TableNumber(const std::string &name) {
+  return strtoull(name.c_str(), nullptr, 10);
+}
+
+} // namespace
+
+leveldb::Status CopyFile(leveldb::Env *srcEnv,
+                         const std::string &src,
+                         leveldb::Env *dstEnv,
+                         const std::string &dst,
+                         uint64_t length) {
+  leveldb::SequentialFile *in;
+  leveldb::Status status = srcEnv->NewSequentialFile(src, &in);
+  if (!status.ok()) {
+    return status;
+  }
+  std::unique_ptr<leveldb::SequentialFile> inGuard(in);
+
+  leveldb::WritableFile *out;
+  status = dstEnv->NewWritableFile(dst, &out);
+  if (!status.ok()) {
+    return status;
+  }
+  std::unique_ptr<leveldb::WritableFile> outGuard(out);
+
+  std::unique_ptr<char[]> scratch(new char[kCopyBufferSize]);
+
+  while (length > 0) {
+    leveldb::Slice chunk;
+    status = in->Read((size_t) std::min<uint64_t>(length, kCopyBufferSize), &chunk, scratch.get());
+    if (!status.ok()) {
+      return status;
+    }
+    if (chunk.empty()) {
+      return leveldb::Status::IOError(src, "file is shorter than expected");
+    }
+
+    status = out->Append(chunk);
+    if (!status.ok()) {
+      return status;
+    }
+    length -= chunk.size();
+  }
+
+  status = out->Sync();
+  if (status.ok()) {
+    status = out->Close();
+  }
+
+  return status;
+}
+
+leveldb::Status CaptureCheckpoint(leveldb::Env *env, const std::string &dbname, CheckpointFiles *files) {
+  leveldb::Status status = leveldb::ReadFileToString(env, dbname + "/CURRENT", &files->current);
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (files->current.empty() || files->current[files->current.size() - 1] != '\n') {
+    return leveldb::Status::Corruption("CURRENT file does not end with newline");
+  }
+
+  // MANIFEST first: every table it references has been written before it,
+  // and none of them can disappear while deletions are paused.
+  std::string manifest = files->current.substr(0, files->current.size() - 1);
+  uint64_t size;
+  status = env->GetFileSize(dbname + "/" + manifest, &size);
+  if (!status.ok()) {
+    return status;
+  }
+  files->prefixes.emplace_back(manifest, size);
+
+  // Only the tables of the captured MANIFEST: those a compaction is still
+  // writing, or has replaced since, are not part of the checkpoint.
+  std::string contents;
+  status = leveldb::ReadFileToString(env, dbname + "/" + manifest, &contents);
+  if (!status.ok()) {
+    return status;
+  }
+  contents.resize((size_t) std::min<uint64_t>(size, contents.size()));
+
+  std::set<uint64_t> live;
+  status = LiveTables(contents, &live);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::vector<std::string> children;
+  status = env->GetChildren(dbname, &children);
+  if (!status.ok()) {
+    return status;
+  }
+
+  for (const std::string &child: children) {
+    bool table = IsTable(child);
+    if (table ? live.count(TableNumber(child)) == 0 : !IsLog(child)) {
+      continue;
+    }
+
+    status = env->GetFileSize(dbname + "/" + child, &size);
+    if (!status.ok()) {
+      return status;
+    }
+
+    if (table) {
+      files->tables.emplace_back(child, size);
+    } else {
+      files->prefixes.emplace_back(child, size);
+    }
+  }
+
+  return leveldb::Status::OK();
+}
+
+leveldb::Status WriteCheckpoint(leveldb::Env *env,
+                                const std::string &dbname,
+                                const CheckpointFiles &files,
+                                leveldb::Env *targetEnv,
+                                const std::string &target,
+                                bool incremental,
+                                bool linkTables) {
+  leveldb::Status status;
+
+  std::string staging = target + ".tmp";
+  std::string previous = target + ".old";
+
+  // A crash between the renames of a swap leaves only the previous checkpoint.
+  if (incremental && !targetEnv->FileExists(target) && targetEnv->FileExists(previous)) {
+    status = targetEnv->RenameFile(previous, target);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  // Tables already in the target and their sizes.
+  std::map<std::string, uint64_t> existing;
+  bool empty = true;
+
+  if (targetEnv->FileExists(target)) {
+    std::vector<std::string> children;
+    status = targetEnv->GetChildren(target, &children);
+    if (!status.ok()) {
+      return status;
+    }
+
+    for (const std::string &child: children) {
+      if (child == "." || child == "..") {
+        continue;
+      }
+      if (!incremental) {
+        return leveldb::Status::InvalidArgument("Checkpoint directory is not empty", target);
+      }
+      empty = false;
+
+      uint64_t size = 0;
+      if (IsTable(child) && targetEnv->GetFileSize(target + "/" + child, &size).ok()) {
+        existing[child] = size;
+      }
+    }
+  }
+
+  // The previous checkpoint stays untouched until the new one is complete:
+  // it's written next to it and swapped in.
+  std::string dir = empty ? target : staging;
+  if (!empty) {
+    RemoveDirectory(targetEnv, staging);
+  }
+  if (!targetEnv->FileExists(dir)) {
+    status = targetEnv->CreateDir(dir);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  for (const auto &table: files.tables) {
+    std::string dst = dir + "/" + table.first;
+
+    auto kept = existing.find(table.first);
+    if (kept != existing.end() && kept->second == table.second) {
+      std::string src = target + "/" + table.first;
+      status = LinkFile(src, dst) ? leveldb::Status::OK() : CopyFile(targetEnv, src, targetEnv, dst, table.second);
+    } else {
+      std::string src = dbname + "/" + table.first;
+      status = linkTables && LinkFile(src, dst) ? leveldb::Status::OK() : CopyFile(env, src, targetEnv, dst, table.second);
+    }
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  for (const auto &prefix: files.prefixes) {
+    status = CopyFile(env, dbname + "/" + prefix.first, targetEnv, dir + "/" + prefix.first, prefix.second);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  status = WriteFileSync(targetEnv, dir + "/CURRENT", files.current);
+  if (!status.ok() || empty) {
+    return status;
+  }
+
+  // Left over if a crash followed the swap.
+  RemoveDirectory(targetEnv, previous);
+
+  status = targetEnv->RenameFile(target, previous);
+  if (status.ok()) {
+    status = targetEnv->RenameFile(staging, target);
+  }
+  if (!status.ok()) {
+    return status;
+  }
+
+  RemoveDirectory(targetEnv, previous);
+  return leveldb::Status::OK();
+}
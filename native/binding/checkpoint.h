@@ -0,0 +1,51 @@
+#ifndef LEVELDB_ANDROID_CHECKPOINT_H
+#define LEVELDB_ANDROID_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+
+// Files that make up a consistent state of a database directory.
+struct CheckpointFiles {
+  // Contents of CURRENT.
+  std::string current;
+  // MANIFEST and logs with the sizes they had when captured. Both are only
+  // ever appended to, so their prefixes are what the checkpoint needs.
+  std::vector<std::pair<std::string, uint64_t>> prefixes;
+  // Table files with their sizes. Tables are immutable.
+  std::vector<std::pair<std::string, uint64_t>> tables;
+};
+
+// Lists the files of the database `dbname`: its MANIFEST, the tables that
+// MANIFEST references and the logs. The caller must keep writers out
+// for the duration of the call and keep file deletions paused until the
+// checkpoint is written.
+leveldb::Status CaptureCheckpoint(leveldb::Env *env, const std::string &dbname, CheckpointFiles *files);
+
+// Writes the captured files to `target`. Tables are hard-linked when
+// `linkTables` is set and the link succeeds, copied otherwise. Without
+// `incremental` the target directory must be empty or missing; with it, the
+// target may hold a previous checkpoint: the new one is written to
+// "<target>.tmp", reusing the unchanged tables of the previous one, and
+// replaces it only once complete. Whatever else was in the target goes away
+// with the previous checkpoint.
+leveldb::Status WriteCheckpoint(leveldb::Env *env,
+                                const std::string &dbname,
+                                const CheckpointFiles &files,
+                                leveldb::Env *targetEnv,
+                                const std::string &target,
+                                bool incremental,
+                                bool linkTables);
+
+// Copies the first `length` bytes of `src` to a new file `dst`.
+leveldb::Status CopyFile(leveldb::Env *srcEnv,
+                         const std::string &src,
+                         leveldb::Env *dstEnv,
+                         const std::string &dst,
+                         uint64_t length);
+
+#endif //LEVELDB_ANDROID_CHECKPOINT_H
@@ -38,8 +38,20 @@
 #include "leveldb/write_batch.h"
 #include "leveldb/env.h"
 #include "leveldb/cache.h"
+#include <algorithm>
 #include <typeinfo>
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "jni_util.h"
+#include "memory_budget.h"
+#include "ndb_holder.h"
+#include "primitive_codec.h"
+#include "readahead.h"
+#include "transaction.h"
+#include "transfer.h"
 
 #ifdef ANDROID
 #include <android/log.h>
@@ -47,86 +59,154 @@
 #include "leveldb_logger.h"
 #endif
 
-// Redirects leveldb's logging to the Android logger.
-class AndroidLogger final: public leveldb::Logger {
+namespace {
+
+// Size of the Java array transfer streams are copied through.
+const jsize kStreamBufferSize = 64 << 10;
+
+// Writes to a java.io.OutputStream, on the calling thread.
+class JavaStreamSink : public TransferSink {
  public:
-  void Logv(const char *format, va_list ap) override {
-//        __android_log_vprint(ANDROID_LOG_INFO, "com.edwardstock.leveldb:N", format, ap);
+  JavaStreamSink(JNIEnv *env, jobject stream)
+      : env_(env),
+        stream_(stream),
+        write_(env->GetMethodID(env->GetObjectClass(stream), "write", "([BII)V")),
+        flush_(env->GetMethodID(env->GetObjectClass(stream), "flush", "()V")),
+        buffer_(env->NewByteArray(kStreamBufferSize)) {}
+
+  ~JavaStreamSink() override {
+    env_->DeleteLocalRef(buffer_);
   }
-};
 
-// Holds references to heap-allocated native objects so that they can be
-// closed in Java_com_edwardstock_leveldb_implementation_NativeLevelDB_nclose.
-class NDBHolder {
- public:
-  NDBHolder(leveldb::DB *ldb, AndroidLogger *llogger, leveldb::Cache *lcache)
-      : db(ldb), logger(llogger), cache(lcache) {}
+  leveldb::Status Write(const char *data, size_t n) override {
+    while (n > 0) {
+      jsize chunk = (jsize) std::min(n, (size_t) kStreamBufferSize);
+      env_->SetByteArrayRegion(buffer_, 0, chunk, (const jbyte *) data);
+      env_->CallVoidMethod(stream_, write_, buffer_, 0, chunk);
+      if (env_->ExceptionCheck()) {
+        return leveldb::Status::IOError("OutputStream.write() has thrown");
+      }
+      data += chunk;
+      n -= chunk;
+    }
+    return leveldb::Status::OK();
+  }
 
-  leveldb::DB *db;
-  AndroidLogger *logger;
+  leveldb::Status Close() override {
+    env_->CallVoidMethod(stream_, flush_);
+    if (env_->ExceptionCheck()) {
+      return leveldb::Status::IOError("OutputStream.flush() has thrown");
+    }
+    return leveldb::Status::OK();
+  }
 
-  leveldb::Cache *cache;
+ private:
+  JNIEnv *env_;
+  jobject stream_;
+  jmethodID write_;
+  jmethodID flush_;
+  jbyteArray buffer_;
 };
 
-// Throws the appropriate Java exception for the given status. Make sure you
-// check IsNotFound() and similar possible non-exception statuses before calling
-// this. Please release all Java references before calling this.
-void throwExceptionFromStatus(JNIEnv *env, leveldb::Status &status) {
-  if (status.ok()) {
-    return;
+// Reads from a java.io.InputStream, on the calling thread.
+class JavaStreamSource : public TransferSource {
+ public:
+  JavaStreamSource(JNIEnv *env, jobject stream)
+      : env_(env),
+        stream_(stream),
+        read_(env->GetMethodID(env->GetObjectClass(stream), "read", "([BII)I")),
+        buffer_(env->NewByteArray(kStreamBufferSize)) {}
+
+  ~JavaStreamSource() override {
+    env_->DeleteLocalRef(buffer_);
   }
 
-  if (status.IsIOError()) {
-    jclass
-        ioExceptionClass = env->FindClass("com/edwardstock/leveldb/exception/LevelDBIOException");
-
-    env->ThrowNew(ioExceptionClass, status.ToString().data());
-  } else if (status.IsCorruption()) {
-    jclass corruptionExceptionClass =
-        env->FindClass("com/edwardstock/leveldb/exception/LevelDBCorruptionException");
-
-    env->ThrowNew(corruptionExceptionClass, status.ToString().data());
-  } else if (status.IsNotFound()) {
-    jclass notFoundExceptionClass =
-        env->FindClass("com/edwardstock/leveldb/exception/LevelDBNotFoundException");
+  leveldb::Status Read(char *scratch, size_t n, size_t *read) override {
+    *read = 0;
+    while (n > 0) {
+      jsize chunk = (jsize) std::min(n, (size_t) kStreamBufferSize);
+      jint count = env_->CallIntMethod(stream_, read_, buffer_, 0, chunk);
+      if (env_->ExceptionCheck()) {
+        return leveldb::Status::IOError("InputStream.read() has thrown");
+      }
+      if (count <= 0) {
+        // The end of the stream. A stream returning 0 for a non-empty read
+        // is broken, treat it the same.
+        break;
+      }
+      env_->GetByteArrayRegion(buffer_, 0, count, (jbyte *) scratch);
+      scratch += count;
+      n -= count;
+      *read += count;
+      if (count < chunk) {
+        break;
+      }
+    }
+    return leveldb::Status::OK();
+  }
 
-    env->ThrowNew(notFoundExceptionClass, status.ToString().data());
-  } else {
-    jclass exceptionClass = env->FindClass("com/edwardstock/leveldb/exception/LevelDBException");
+ private:
+  JNIEnv *env_;
+  jobject stream_;
+  jmethodID read_;
+  jbyteArray buffer_;
+};
 
-    env->ThrowNew(exceptionClass, status.ToString().data());
+// Copies an optional Java array, returning whether it was present.
+bool BytesFromJava(JNIEnv *env, jbyteArray array, std::string *out) {
+  if (array == nullptr) {
+    return false;
   }
+  out->resize((size_t) env->GetArrayLength(array));
+  env->GetByteArrayRegion(array, 0, (jsize) out->size(), (jbyte *) &(*out)[0]);
+  return true;
 }
 
-extern "C" {
-JNIEXPORT jlong JNICALL
-Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopen
-    (JNIEnv *env,
-     jobject cself,
-     jboolean createIfMissing,
-     jint cacheSize,
-     jint blockSize,
-     jint writeBufferSize,
-     jstring path) {
+jlongArray TransferStatsToJava(JNIEnv *env, const TransferStats &transferStats) {
+  jlong stats[] = {
+      (jlong) transferStats.records,
+      (jlong) transferStats.bytes,
+      (jlong) transferStats.skipped,
+  };
 
-  const char *nativePath = env->GetStringUTFChars(path, 0);
+  jlongArray retval = env->NewLongArray(3);
 
-  leveldb::DB *db;
+  env->SetLongArrayRegion(retval, 0, 3, stats);
 
-  AndroidLogger *logger = new AndroidLogger();
-  leveldb::Cache *cache = NULL;
+  return retval;
+}
 
-  if (cacheSize != 0) {
-    cache = leveldb::NewLRUCache((size_t) cacheSize);
+// Opens the database `dbPath` in `bindingEnv` and returns its holder, which
+// takes over the env. On failure throws, deletes the env and returns 0.
+jlong OpenHolder(JNIEnv *env,
+                 BindingEnv *bindingEnv,
+                 const std::string &dbPath,
+                 jboolean createIfMissing,
+                 jint cacheSize,
+                 jint blockSize,
+                 jint writeBufferSize,
+                 jint changeFeedBufferSize,
+                 jint rowCacheSize,
+                 jboolean throttleWrites,
+                 jint eventQueueSize) {
+  leveldb::DB *db;
+
+  if (eventQueueSize > 0) {
+    // Compaction events report how much they have read.
+    bindingEnv->CountBackgroundReads();
   }
 
+  AndroidLogger *logger = new AndroidLogger((size_t) eventQueueSize, bindingEnv);
+
+  // The size of leveldb's default cache. It's created here so that its usage
+  // can be told apart from the memtables'.
+  leveldb::Cache *cache = leveldb::NewLRUCache(cacheSize != 0 ? (size_t) cacheSize : 8 << 20);
+
   leveldb::Options options;
   options.create_if_missing = createIfMissing == JNI_TRUE;
   options.info_log = logger;
-
-  if (cache != NULL) {
-    options.block_cache = cache;
-  }
+  options.env = bindingEnv;
+  options.block_cache = cache;
 
   if (blockSize != 0) {
     options.block_size = (size_t) blockSize;
@@ -136,17 +216,27 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopen
     options.write_buffer_size = (size_t) writeBufferSize;
   }
 
-  leveldb::Status status = leveldb::DB::Open(options, nativePath, &db);
-
-  env->ReleaseStringUTFChars(path, nativePath);
+  leveldb::Status status = leveldb::DB::Open(options, dbPath, &db);
 
   if (status.ok()) {
-    NDBHolder *holder = new NDBHolder(db, logger, cache);
+    NDBHolder *holder = new NDBHolder(dbPath,
+                                      db,
+                                      logger,
+                                      cache,
+                                      options.block_size,
+                                      options.write_buffer_size,
+                                      bindingEnv,
+                                      (size_t) changeFeedBufferSize,
+                                      (size_t) rowCacheSize,
+                                      throttleWrites == JNI_TRUE);
+
+    MemoryBudget::Default()->Register(holder);
 
     return (jlong) holder;
   } else {
     delete logger;
     delete cache;
+    delete bindingEnv;
   }
 
   throwExceptionFromStatus(env, status);
@@ -154,15 +244,181 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopen
   return 0;
 }
 
+// Key of the primitive entry points: `key` if not null, otherwise the
+// encoded `longKey`, which needs no Java array at all.
+class PrimitiveKey {
+ public:
+  PrimitiveKey(JNIEnv *env, jbyteArray key, jlong longKey) : env_(env), key_(key) {
+    if (key == NULL) {
+      PrimitiveCodec::EncodeLongKey((int64_t) longKey, encoded_);
+      slice_ = leveldb::Slice(encoded_, sizeof(encoded_));
+    } else {
+      data_ = env->GetByteArrayElements(key, 0);
+      slice_ = leveldb::Slice((const char *) data_, (size_t) env->GetArrayLength(key));
+    }
+  }
+
+  ~PrimitiveKey() {
+    if (data_ != NULL) {
+      env_->ReleaseByteArrayElements(key_, data_, JNI_ABORT);
+    }
+  }
+
+  PrimitiveKey(const PrimitiveKey &) = delete;
+  PrimitiveKey &operator=(const PrimitiveKey &) = delete;
+
+  const leveldb::Slice &Slice() const {
+    return slice_;
+  }
+
+ private:
+  JNIEnv *env_;
+  jbyteArray key_;
+  jbyte *data_ = NULL;
+  char encoded_[PrimitiveCodec::kSize];
+  leveldb::Slice slice_;
+};
+
+// Reads a primitive value, through the row cache like nget. NotFound if
+// there is no record.
+leveldb::Status GetPrimitive(NDBHolder *holder, jlong nsnapshot, const leveldb::Slice &key, uint64_t *out) {
+  if (nsnapshot == 0 && holder->rowCache.Enabled()) {
+    RowCache::Handle row;
+
+    if (holder->rowCache.Lookup(key, &row)) {
+      if (!row.Found()) {
+        return leveldb::Status::NotFound(key);
+      }
+      return PrimitiveCodec::DecodeValue(row.Value(), out);
+    }
+  }
+
+  leveldb::ReadOptions readOptions;
+  readOptions.snapshot = (leveldb::Snapshot *) nsnapshot;
+
+  std::string value;
+  leveldb::Status status = holder->Get(readOptions, key, &value);
+  if (!status.ok()) {
+    return status;
+  }
+
+  return PrimitiveCodec::DecodeValue(value, out);
+}
+
+void PutPrimitive(JNIEnv *env, NDBHolder *holder, jboolean sync, const leveldb::Slice &key, uint64_t value) {
+  leveldb::WriteOptions writeOptions;
+  writeOptions.sync = sync == JNI_TRUE;
+
+  char encoded[PrimitiveCodec::kSize];
+  PrimitiveCodec::EncodeFixed64(value, encoded);
+
+  leveldb::WriteBatch batch;
+  batch.Put(key, leveldb::Slice(encoded, sizeof(encoded)));
+
+  leveldb::Status status = holder->Write(writeOptions, &batch);
+
+  throwExceptionFromStatus(env, status);
+}
+
+} // namespace
+
+extern "C" {
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopen
+    (JNIEnv *env,
+     jobject cself,
+     jboolean createIfMissing,
+     jint cacheSize,
+     jint blockSize,
+     jint writeBufferSize,
+     jint changeFeedBufferSize,
+     jint rowCacheSize,
+     jint readaheadSize,
+     jboolean throttleWrites,
+     jint eventQueueSize,
+     jstring path) {
+
+  const char *nativePath = env->GetStringUTFChars(path, 0);
+  std::string dbPath(nativePath);
+  env->ReleaseStringUTFChars(path, nativePath);
+
+  BindingEnv *bindingEnv = new BindingEnv(leveldb::Env::Default(), (size_t) readaheadSize);
+
+  return OpenHolder(env,
+                    bindingEnv,
+                    dbPath,
+                    createIfMissing,
+                    cacheSize,
+                    blockSize,
+                    writeBufferSize,
+                    changeFeedBufferSize,
+                    rowCacheSize,
+                    throttleWrites,
+                    eventQueueSize);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopenInMemory
+    (JNIEnv *env,
+     jobject cself,
+     jint cacheSize,
+     jint blockSize,
+     jint writeBufferSize,
+     jint changeFeedBufferSize,
+     jint rowCacheSize,
+     jboolean throttleWrites,
+     jint eventQueueSize,
+     jlong memoryLimit,
+     jstring loadFrom,
+     jstring path) {
+
+  std::string dbPath = stringFromJava(env, path);
+  BindingEnv *bindingEnv = BindingEnv::NewInMemory((uint64_t) memoryLimit);
+
+  if (loadFrom != NULL) {
+    // Same as a checkpoint of the on-disk database into the new env.
+    std::string source = stringFromJava(env, loadFrom);
+    leveldb::Env *disk = leveldb::Env::Default();
+
+    CheckpointFiles files;
+    leveldb::Status status = CaptureCheckpoint(disk, source, &files);
+    if (status.ok()) {
+      status = WriteCheckpoint(disk, source, files, bindingEnv, dbPath, false, false);
+    }
+
+    if (!status.ok()) {
+      delete bindingEnv;
+      throwExceptionFromStatus(env, status);
+      return 0;
+    }
+  }
+
+  return OpenHolder(env,
+                    bindingEnv,
+                    dbPath,
+                    JNI_TRUE,
+                    cacheSize,
+                    blockSize,
+                    writeBufferSize,
+                    changeFeedBufferSize,
+                    rowCacheSize,
+                    throttleWrites,
+                    eventQueueSize);
+}
+
 JNIEXPORT void JNICALL
 Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nclose
     (JNIEnv *env, jobject cself, jlong ndb) {
   if (ndb != 0) {
     NDBHolder *holder = (NDBHolder *) ndb;
 
+    MemoryBudget::Default()->Unregister(holder);
+    holder->iteratorPool.Clear();
+
     delete holder->db;
     delete holder->cache;
     delete holder->logger;
+    delete holder->env;
     delete holder;
   }
 }
@@ -183,7 +439,10 @@ JNIEXPORT void JNICALL Java_com_edwardstock_leveldb_implementation_NativeLevelDB
   leveldb::Slice keySlice(keyData, (size_t) env->GetArrayLength(key));
   leveldb::Slice valueSlice(valueData, (size_t) env->GetArrayLength(value));
 
-  leveldb::Status status = db->Put(writeOptions, keySlice, valueSlice);
+  leveldb::WriteBatch batch;
+  batch.Put(keySlice, valueSlice);
+
+  leveldb::Status status = holder->Write(writeOptions, &batch);
 
   env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
   env->ReleaseByteArrayElements(value, (jbyte *) valueData, 0);
@@ -204,7 +463,7 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nwrite
 
   leveldb::WriteBatch *wb = (leveldb::WriteBatch *) nwb;
 
-  leveldb::Status status = db->Write(options, wb);
+  leveldb::Status status = holder->Write(options, wb);
 
   throwExceptionFromStatus(env, status);
 }
@@ -225,9 +484,28 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nget
 
   leveldb::Slice keySlice(keyData, env->GetArrayLength(key));
 
+  if (nsnapshot == 0 && holder->rowCache.Enabled()) {
+    RowCache::Handle row;
+
+    if (holder->rowCache.Lookup(keySlice, &row)) {
+      env->ReleaseByteArrayElements(key, (jbyte *) keyData, JNI_ABORT);
+
+      leveldb::Slice cached = row.Value();
+      if (!row.Found() || cached.size() < 1) {
+        return 0;
+      }
+
+      jbyteArray retval = env->NewByteArray(cached.size());
+
+      env->SetByteArrayRegion(retval, 0, cached.size(), (jbyte *) cached.data());
+
+      return retval;
+    }
+  }
+
   std::string value;
 
-  leveldb::Status status = db->Get(readOptions, keySlice, &value);
+  leveldb::Status status = holder->Get(readOptions, keySlice, &value);
 
   env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
 
@@ -265,7 +543,10 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ndelete
   leveldb::WriteOptions writeOptions;
   writeOptions.sync = sync == JNI_TRUE;
 
-  leveldb::Status status = db->Delete(writeOptions, keySlice);
+  leveldb::WriteBatch batch;
+  batch.Delete(keySlice);
+
+  leveldb::Status status = holder->Write(writeOptions, &batch);
 
   env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
 
@@ -346,7 +627,13 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_niterat
 
   options.fill_cache = (bool) fillCache;
 
-  leveldb::Iterator *it = db->NewIterator(options);
+  leveldb::Iterator *it = SecondaryIndexes::HideEntries(db->NewIterator(options));
+
+  if (!options.fill_cache && holder->env->Readahead() != 0) {
+    it = new ScanIterator(it);
+  }
+
+  holder->TrackIterator(it, options.fill_cache);
 
   return (jlong) it;
 }
@@ -357,9 +644,7 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nsnapsh
 
   NDBHolder *holder = (NDBHolder *) ndb;
 
-  leveldb::DB *db = holder->db;
-
-  return (jlong) db->GetSnapshot();
+  return (jlong) holder->snapshots.Acquire(holder->db, holder->LastSequence());
 }
 
 JNIEXPORT void JNICALL
@@ -371,9 +656,655 @@ Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreleas
 
   NDBHolder *holder = (NDBHolder *) ndb;
 
-  leveldb::DB *db = holder->db;
+  holder->snapshots.Release(holder->db, (leveldb::Snapshot *) nsnapshot);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nregisterIndex
+    (JNIEnv *env,
+     jobject cself,
+     jlong ndb,
+     jstring name,
+     jint type,
+     jint offset,
+     jint length,
+     jbyte delimiter) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  IndexSpec spec;
+  spec.name = stringFromJava(env, name);
+  spec.type = type;
+  spec.offset = offset;
+  spec.length = length;
+  spec.delimiter = (char) delimiter;
+
+  leveldb::Status status = holder->RegisterIndex(spec);
+
+  throwExceptionFromStatus(env, status);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ndropIndex
+    (JNIEnv *env, jobject cself, jlong ndb, jstring name, jboolean purge) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  leveldb::Status status = holder->DropIndex(stringFromJava(env, name), purge == JNI_TRUE);
+
+  throwExceptionFromStatus(env, status);
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nlookupByIndex
+    (JNIEnv *env,
+     jobject cself,
+     jlong ndb,
+     jstring name,
+     jbyteArray indexKey,
+     jint limit,
+     jlong nsnapshot) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  const char *indexKeyData = (char *) env->GetByteArrayElements(indexKey, 0);
+  leveldb::Slice indexKeySlice(indexKeyData, (size_t) env->GetArrayLength(indexKey));
+
+  std::vector<std::string> values;
+
+  leveldb::Status status = holder->indexes.Lookup(holder->db,
+                                                  (leveldb::Snapshot *) nsnapshot,
+                                                  stringFromJava(env, name),
+                                                  indexKeySlice,
+                                                  limit > 0 ? (size_t) limit : 0,
+                                                  &values);
+
+  env->ReleaseByteArrayElements(indexKey, (jbyte *) indexKeyData, 0);
+
+  if (!status.ok()) {
+    throwExceptionFromStatus(env, status);
+    return nullptr;
+  }
+
+  jobjectArray retval = env->NewObjectArray(values.size(), env->FindClass("[B"), nullptr);
+
+  for (size_t i = 0; i < values.size(); i++) {
+    jbyteArray value = env->NewByteArray(values[i].length());
+    env->SetByteArrayRegion(value, 0, values[i].length(), (jbyte *) values[i].data());
+    env->SetObjectArrayElement(retval, i, value);
+    env->DeleteLocalRef(value);
+  }
+
+  return retval;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nrebuildIndex
+    (JNIEnv *env, jobject cself, jlong ndb, jstring name, jint threads) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  leveldb::Status status = holder->RebuildIndex(stringFromJava(env, name), threads);
+
+  throwExceptionFromStatus(env, status);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nbeginTransaction
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  return (jlong) new Transaction(holder);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ncheckpoint
+    (JNIEnv *env, jobject cself, jlong ndb, jstring targetDir, jboolean incremental) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  uint64_t sequence = 0;
+  leveldb::Status status = holder->Checkpoint(stringFromJava(env, targetDir), incremental == JNI_TRUE, &sequence);
+
+  if (!status.ok()) {
+    throwExceptionFromStatus(env, status);
+    return 0;
+  }
+
+  return (jlong) sequence;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nlastSequence
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  return (jlong) holder->LastSequence();
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreadChanges
+    (JNIEnv *env, jobject cself, jlong ndb, jlong afterSequence, jint maxRecords) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  std::string changes;
+  if (!holder->feed.Read((uint64_t) afterSequence, (size_t) maxRecords, &changes)) {
+    throwException(env,
+                   "com/edwardstock/leveldb/exception/LevelDBChangeFeedTruncatedException",
+                   "Changes following the requested sequence have been evicted from the change feed");
+    return 0;
+  }
+
+  jbyteArray retval = env->NewByteArray(changes.size());
+
+  env->SetByteArrayRegion(retval, 0, changes.size(), (jbyte *) changes.data());
+
+  return retval;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nrowCacheStats
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  RowCache &rowCache = holder->rowCache;
+
+  jlong stats[] = {
+      (jlong) rowCache.Hits(),
+      (jlong) rowCache.Misses(),
+      (jlong) rowCache.Usage(),
+      (jlong) rowCache.Capacity(),
+  };
+
+  jlongArray retval = env->NewLongArray(4);
+
+  env->SetLongArrayRegion(retval, 0, 4, stats);
+
+  return retval;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntryPut
+    (JNIEnv *env, jobject cself, jlong ndb, jboolean sync, jbyteArray key, jbyteArray value) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  leveldb::WriteOptions writeOptions;
+  writeOptions.sync = sync == JNI_TRUE;
+
+  const char *keyData = (char *) env->GetByteArrayElements(key, 0);
+  const char *valueData = (char *) env->GetByteArrayElements(value, 0);
+
+  leveldb::Slice keySlice(keyData, (size_t) env->GetArrayLength(key));
+  leveldb::Slice valueSlice(valueData, (size_t) env->GetArrayLength(value));
+
+  leveldb::WriteBatch batch;
+  batch.Put(keySlice, valueSlice);
+
+  uint64_t retryAfter = 0;
+  leveldb::Status status = holder->TryWrite(writeOptions, &batch, &retryAfter);
+
+  env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
+  env->ReleaseByteArrayElements(value, (jbyte *) valueData, 0);
+
+  throwExceptionFromStatus(env, status);
+
+  return (jlong) retryAfter;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntryWrite
+    (JNIEnv *env, jobject cself, jlong ndb, jboolean sync, jlong nwb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  leveldb::WriteOptions options;
+  options.sync = sync == JNI_TRUE;
+
+  uint64_t retryAfter = 0;
+  leveldb::Status status = holder->TryWrite(options, (leveldb::WriteBatch *) nwb, &retryAfter);
+
+  throwExceptionFromStatus(env, status);
+
+  return (jlong) retryAfter;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nwritePressure
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  WritePressure &pressure = holder->logger->pressure;
+
+  jlong stats[] = {
+      (jlong) pressure.L0Files(holder->db),
+      (jlong) (pressure.Flushing() ? 1 : 0),
+      (jlong) pressure.StalledWriters(),
+      (jlong) pressure.Stalls(),
+      (jlong) pressure.StallMicros(),
+      (jlong) pressure.ThrottledWrites(),
+      (jlong) pressure.ThrottleMicros(),
+  };
+
+  jlongArray retval = env->NewLongArray(7);
+
+  env->SetLongArrayRegion(retval, 0, 7, stats);
+
+  return retval;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nputLong
+    (JNIEnv *env, jobject cself, jlong ndb, jboolean sync, jbyteArray key, jlong longKey, jlong value) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  PrimitiveKey primitiveKey(env, key, longKey);
+
+  PutPrimitive(env, holder, sync, primitiveKey.Slice(), (uint64_t) value);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nputDouble
+    (JNIEnv *env, jobject cself, jlong ndb, jboolean sync, jbyteArray key, jlong longKey, jdouble value) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  PrimitiveKey primitiveKey(env, key, longKey);
+
+  PutPrimitive(env, holder, sync, primitiveKey.Slice(), PrimitiveCodec::FromDouble(value));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetLong
+    (JNIEnv *env, jobject cself, jlong ndb, jbyteArray key, jlong longKey, jlong defaultValue, jlong nsnapshot) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  PrimitiveKey primitiveKey(env, key, longKey);
+
+  uint64_t value;
+  leveldb::Status status = GetPrimitive(holder, nsnapshot, primitiveKey.Slice(), &value);
+
+  if (status.ok()) {
+    return (jlong) value;
+  } else if (status.IsNotFound()) {
+    return defaultValue;
+  }
+
+  throwExceptionFromStatus(env, status);
+  return defaultValue;
+}
+
+JNIEXPORT jdouble JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetDouble
+    (JNIEnv *env, jobject cself, jlong ndb, jbyteArray key, jlong longKey, jdouble defaultValue, jlong nsnapshot) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  PrimitiveKey primitiveKey(env, key, longKey);
+
+  uint64_t value;
+  leveldb::Status status = GetPrimitive(holder, nsnapshot, primitiveKey.Slice(), &value);
+
+  if (status.ok()) {
+    return PrimitiveCodec::ToDouble(value);
+  } else if (status.IsNotFound()) {
+    return defaultValue;
+  }
+
+  throwExceptionFromStatus(env, status);
+  return defaultValue;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetLongs
+    (JNIEnv *env, jobject cself, jlong ndb, jlongArray keys, jlongArray values, jlong defaultValue, jlong nsnapshot) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  jsize count = env->GetArrayLength(keys);
+  jlong *keyData = env->GetLongArrayElements(keys, 0);
+  jlong *valueData = env->GetLongArrayElements(values, 0);
+
+  char encoded[PrimitiveCodec::kSize];
+  leveldb::Slice key(encoded, sizeof(encoded));
+
+  jint found = 0;
+  leveldb::Status status;
+
+  for (jsize i = 0; i < count; i++) {
+    PrimitiveCodec::EncodeLongKey((int64_t) keyData[i], encoded);
+
+    uint64_t value;
+    status = GetPrimitive(holder, nsnapshot, key, &value);
+
+    if (status.ok()) {
+      valueData[i] = (jlong) value;
+      found++;
+    } else if (status.IsNotFound()) {
+      valueData[i] = defaultValue;
+      status = leveldb::Status::OK();
+    } else {
+      break;
+    }
+  }
+
+  env->ReleaseLongArrayElements(keys, keyData, JNI_ABORT);
+  env->ReleaseLongArrayElements(values, valueData, 0);
+
+  throwExceptionFromStatus(env, status);
+
+  return found;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nincrementLong
+    (JNIEnv *env, jobject cself, jlong ndb, jboolean sync, jbyteArray key, jlong longKey, jlong delta) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  PrimitiveKey primitiveKey(env, key, longKey);
+
+  leveldb::WriteOptions writeOptions;
+  writeOptions.sync = sync == JNI_TRUE;
+
+  int64_t result = 0;
+  leveldb::Status status = holder->IncrementLong(writeOptions, primitiveKey.Slice(), (int64_t) delta, &result);
+
+  throwExceptionFromStatus(env, status);
+
+  return (jlong) result;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nsnapshotStats
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  SnapshotRegistry::Stats snapshots = holder->snapshots.GetStats();
+
+  jlong stats[] = {
+      (jlong) snapshots.count,
+      (jlong) snapshots.oldestSequence,
+      (jlong) (snapshots.oldestAgeMicros / 1000),
+  };
+
+  jlongArray retval = env->NewLongArray(3);
+
+  env->SetLongArrayRegion(retval, 0, 3, stats);
+
+  return retval;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_npollEvents
+    (JNIEnv *env, jobject cself, jlong ndb, jlongArray buffer, jint timeoutMillis) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  size_t max = (size_t) env->GetArrayLength(buffer) / DBEvent::kFields;
+  if (max == 0) {
+    return 0;
+  }
+
+  std::vector<DBEvent> events(max);
+  size_t count = holder->logger->events.Poll(events.data(), max, timeoutMillis);
+
+  if (count != 0) {
+    std::vector<jlong> fields;
+    fields.reserve(count * DBEvent::kFields);
+
+    for (size_t i = 0; i < count; i++) {
+      const DBEvent &event = events[i];
+      fields.insert(fields.end(), {event.type, event.level, event.a, event.b, event.c, event.d});
+    }
+
+    env->SetLongArrayRegion(buffer, 0, (jsize) fields.size(), fields.data());
+  }
+
+  return (jint) count;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nstopEvents
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+  holder->logger->events.Stop();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nexport
+    (JNIEnv *env,
+     jobject cself,
+     jlong ndb,
+     jlong nsnapshot,
+     jbyteArray start,
+     jbyteArray limit,
+     jint fd,
+     jstring path,
+     jobject stream,
+     jboolean compress) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  if (compress == JNI_TRUE && !TransferWriter::CompressionSupported()) {
+    throwException(env,
+                   "com/edwardstock/leveldb/exception/LevelDBException",
+                   "The library has been built without zlib");
+    return nullptr;
+  }
+
+  std::unique_ptr<TransferSink> sink;
+  leveldb::Status status;
+  if (stream != nullptr) {
+    sink.reset(new JavaStreamSink(env, stream));
+  } else if (path != nullptr) {
+    status = NewFileSink(leveldb::Env::Default(), stringFromJava(env, path), &sink);
+  } else {
+    status = NewFdSink(fd, &sink);
+  }
+
+  std::string startKey, limitKey;
+  bool hasStart = BytesFromJava(env, start, &startKey);
+  bool hasLimit = BytesFromJava(env, limit, &limitKey);
+  leveldb::Slice startSlice(startKey), limitSlice(limitKey);
+
+  TransferStats stats;
+  if (status.ok()) {
+    leveldb::ReadOptions readOptions;
+    readOptions.snapshot = (leveldb::Snapshot *) nsnapshot;
+
+    status = holder->Export(readOptions,
+                            hasStart ? &startSlice : nullptr,
+                            hasLimit ? &limitSlice : nullptr,
+                            compress == JNI_TRUE,
+                            sink.get(),
+                            &stats);
+  }
+  sink.reset();
 
-  db->ReleaseSnapshot((leveldb::Snapshot *) nsnapshot);
+  if (env->ExceptionCheck()) {
+    // Thrown by the Java stream, let it through.
+    return nullptr;
+  }
+  if (!status.ok()) {
+    throwExceptionFromStatus(env, status);
+    return nullptr;
+  }
+
+  return TransferStatsToJava(env, stats);
 }
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nimport
+    (JNIEnv *env, jobject cself, jlong ndb, jint fd, jstring path, jobject stream, jboolean sync) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  std::unique_ptr<TransferSource> source;
+  leveldb::Status status;
+  if (stream != nullptr) {
+    source.reset(new JavaStreamSource(env, stream));
+  } else if (path != nullptr) {
+    status = NewFileSource(leveldb::Env::Default(), stringFromJava(env, path), &source);
+  } else {
+    status = NewFdSource(fd, &source);
+  }
+
+  TransferStats stats;
+  if (status.ok()) {
+    leveldb::WriteOptions writeOptions;
+    writeOptions.sync = sync == JNI_TRUE;
+
+    status = holder->Import(source.get(), writeOptions, &stats);
+  }
+  source.reset();
+
+  if (env->ExceptionCheck()) {
+    return nullptr;
+  }
+  if (!status.ok()) {
+    throwExceptionFromStatus(env, status);
+    return nullptr;
+  }
+
+  return TransferStatsToJava(env, stats);
 }
 
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nmemoryUsage
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  MemoryUsage usage;
+  holder->GetMemoryUsage(&usage);
+
+  jlong stats[] = {
+      (jlong) usage.memtables,
+      (jlong) usage.blockCache,
+      (jlong) usage.rowCache,
+      (jlong) usage.tableIndexes,
+      (jlong) usage.iterators,
+      (jlong) usage.files,
+  };
+
+  jlongArray retval = env->NewLongArray(6);
+
+  env->SetLongArrayRegion(retval, 0, 6, stats);
+
+  return retval;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nsetMemoryBudget
+    (JNIEnv *env, jobject cself, jlong limit) {
+
+  MemoryBudget *budget = MemoryBudget::Default();
+  budget->SetLimit((uint64_t) limit);
+  budget->Enforce();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nmemoryBudgetStats
+    (JNIEnv *env, jobject cself) {
+
+  MemoryBudget *budget = MemoryBudget::Default();
+
+  jlong stats[] = {
+      (jlong) budget->Limit(),
+      (jlong) budget->Usage(),
+      (jlong) budget->Enforcements(),
+      (jlong) budget->Flushes(),
+  };
+
+  jlongArray retval = env->NewLongArray(4);
+
+  env->SetLongArrayRegion(retval, 0, 4, stats);
+
+  return retval;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntrimMemory
+    (JNIEnv *env, jobject cself) {
+
+  MemoryBudget::Default()->Trim();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nacquireIterator
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  return (jlong) holder->AcquireIterator();
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreleaseIterator
+    (JNIEnv *env, jobject cself, jlong ndb, jlong nit) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  holder->ReleaseIterator((leveldb::Iterator *) nit);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nscan
+    (JNIEnv *env, jobject cself, jlong ndb, jbyteArray start, jbyteArray limit, jint n, jlong nsnapshot) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  std::string startKey, limitKey;
+  bool hasStart = BytesFromJava(env, start, &startKey);
+  bool hasLimit = BytesFromJava(env, limit, &limitKey);
+  leveldb::Slice startSlice(startKey), limitSlice(limitKey);
+
+  std::string records;
+  leveldb::Status status = holder->Scan((leveldb::Snapshot *) nsnapshot,
+                                        hasStart ? &startSlice : nullptr,
+                                        hasLimit ? &limitSlice : nullptr,
+                                        n > 0 ? (size_t) n : 0,
+                                        &records);
+
+  if (!status.ok()) {
+    throwExceptionFromStatus(env, status);
+    return nullptr;
+  }
+
+  jbyteArray retval = env->NewByteArray(records.size());
+
+  env->SetByteArrayRegion(retval, 0, records.size(), (jbyte *) records.data());
+
+  return retval;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_niteratorPoolStats
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  jlong stats[] = {
+      (jlong) holder->iteratorPool.Hits(),
+      (jlong) holder->iteratorPool.Misses(),
+      (jlong) holder->iteratorPool.IdleCount(),
+  };
+
+  jlongArray retval = env->NewLongArray(3);
+
+  env->SetLongArrayRegion(retval, 0, 3, stats);
+
+  return retval;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreadaheadBytesRead
+    (JNIEnv *env, jobject cself, jlong ndb) {
+
+  NDBHolder *holder = (NDBHolder *) ndb;
+
+  return (jlong) holder->env->ReadaheadBytesRead();
+}
+}
@@ -10,11 +10,11 @@ extern "C" {
 /*
  * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
  * Method:    nopen
- * Signature: (ZIIILjava/lang/String;)J
+ * Signature: (ZIIIIIIZILjava/lang/String;)J
  */
 JNIEXPORT jlong JNICALL
 Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopen
-    (JNIEnv *, jobject, jboolean, jint, jint, jint, jstring);
+    (JNIEnv *, jobject, jboolean, jint, jint, jint, jint, jint, jint, jboolean, jint, jstring);
 
 /*
  * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
@@ -114,6 +114,303 @@ JNIEXPORT void JNICALL
 Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreleaseSnapshot
     (JNIEnv *, jobject, jlong, jlong);
 
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nregisterIndex
+ * Signature: (JLjava/lang/String;IIIB)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nregisterIndex
+    (JNIEnv *, jobject, jlong, jstring, jint, jint, jint, jbyte);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ndropIndex
+ * Signature: (JLjava/lang/String;Z)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ndropIndex
+    (JNIEnv *, jobject, jlong, jstring, jboolean);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nlookupByIndex
+ * Signature: (JLjava/lang/String;[BIJ)[[B
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nlookupByIndex
+    (JNIEnv *, jobject, jlong, jstring, jbyteArray, jint, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nrebuildIndex
+ * Signature: (JLjava/lang/String;I)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nrebuildIndex
+    (JNIEnv *, jobject, jlong, jstring, jint);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nbeginTransaction
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nbeginTransaction
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ncheckpoint
+ * Signature: (JLjava/lang/String;Z)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ncheckpoint
+    (JNIEnv *, jobject, jlong, jstring, jboolean);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nlastSequence
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nlastSequence
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nreadChanges
+ * Signature: (JJI)[B
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreadChanges
+    (JNIEnv *, jobject, jlong, jlong, jint);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nrowCacheStats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nrowCacheStats
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ntryPut
+ * Signature: (JZ[B[B)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntryPut
+    (JNIEnv *, jobject, jlong, jboolean, jbyteArray, jbyteArray);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ntryWrite
+ * Signature: (JZJ)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntryWrite
+    (JNIEnv *, jobject, jlong, jboolean, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nwritePressure
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nwritePressure
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nopenInMemory
+ * Signature: (IIIIIZIJLjava/lang/String;Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nopenInMemory
+    (JNIEnv *, jobject, jint, jint, jint, jint, jint, jboolean, jint, jlong, jstring, jstring);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nputLong
+ * Signature: (JZ[BJJ)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nputLong
+    (JNIEnv *, jobject, jlong, jboolean, jbyteArray, jlong, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nputDouble
+ * Signature: (JZ[BJD)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nputDouble
+    (JNIEnv *, jobject, jlong, jboolean, jbyteArray, jlong, jdouble);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ngetLong
+ * Signature: (J[BJJJ)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetLong
+    (JNIEnv *, jobject, jlong, jbyteArray, jlong, jlong, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ngetDouble
+ * Signature: (J[BJDJ)D
+ */
+JNIEXPORT jdouble JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetDouble
+    (JNIEnv *, jobject, jlong, jbyteArray, jlong, jdouble, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ngetLongs
+ * Signature: (J[J[JJJ)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ngetLongs
+    (JNIEnv *, jobject, jlong, jlongArray, jlongArray, jlong, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nincrementLong
+ * Signature: (JZ[BJJ)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nincrementLong
+    (JNIEnv *, jobject, jlong, jboolean, jbyteArray, jlong, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nsnapshotStats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nsnapshotStats
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    npollEvents
+ * Signature: (J[JI)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_npollEvents
+    (JNIEnv *, jobject, jlong, jlongArray, jint);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nstopEvents
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nstopEvents
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nexport
+ * Signature: (JJ[B[BILjava/lang/String;Ljava/io/OutputStream;Z)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nexport
+    (JNIEnv *, jobject, jlong, jlong, jbyteArray, jbyteArray, jint, jstring, jobject, jboolean);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nimport
+ * Signature: (JILjava/lang/String;Ljava/io/InputStream;Z)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nimport
+    (JNIEnv *, jobject, jlong, jint, jstring, jobject, jboolean);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nmemoryUsage
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nmemoryUsage
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nsetMemoryBudget
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nsetMemoryBudget
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nmemoryBudgetStats
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nmemoryBudgetStats
+    (JNIEnv *, jobject);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    ntrimMemory
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_ntrimMemory
+    (JNIEnv *, jobject);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nacquireIterator
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nacquireIterator
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nreleaseIterator
+ * Signature: (JJ)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreleaseIterator
+    (JNIEnv *, jobject, jlong, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nscan
+ * Signature: (J[B[BIJ)[B
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nscan
+    (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jint, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    niteratorPoolStats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_niteratorPoolStats
+    (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeLevelDB
+ * Method:    nreadaheadBytesRead
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeLevelDB_00024Companion_nreadaheadBytesRead
+    (JNIEnv *, jobject, jlong);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,106 @@
+#include "com_edwardstock_leveldb_implementation_NativeTransaction.h"
+
+#include <string>
+
+#include "jni_util.h"
+#include "transaction.h"
+
+extern "C" {
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nget
+    (JNIEnv *env, jobject cself, jlong ntx, jbyteArray key) {
+
+  Transaction *tx = (Transaction *) ntx;
+
+  const char *keyData = (char *) env->GetByteArrayElements(key, 0);
+  leveldb::Slice keySlice(keyData, (size_t) env->GetArrayLength(key));
+
+  std::string value;
+
+  leveldb::Status status = tx->Get(keySlice, &value);
+
+  env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
+
+  if (status.ok()) {
+    if (value.length() < 1) {
+      return 0;
+    }
+
+    jbyteArray retval = env->NewByteArray(value.length());
+
+    env->SetByteArrayRegion(retval, 0, value.length(), (jbyte *) value.data());
+
+    return retval;
+  } else if (status.IsNotFound()) {
+    return 0;
+  }
+
+  throwExceptionFromStatus(env, status);
+
+  return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nput
+    (JNIEnv *env, jobject cself, jlong ntx, jbyteArray key, jbyteArray value) {
+
+  Transaction *tx = (Transaction *) ntx;
+
+  const char *keyData = (char *) env->GetByteArrayElements(key, 0);
+  const char *valueData = (char *) env->GetByteArrayElements(value, 0);
+
+  leveldb::Slice keySlice(keyData, (size_t) env->GetArrayLength(key));
+  leveldb::Slice valueSlice(valueData, (size_t) env->GetArrayLength(value));
+
+  tx->Put(keySlice, valueSlice);
+
+  env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
+  env->ReleaseByteArrayElements(value, (jbyte *) valueData, 0);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_ndelete
+    (JNIEnv *env, jobject cself, jlong ntx, jbyteArray key) {
+
+  Transaction *tx = (Transaction *) ntx;
+
+  const char *keyData = (char *) env->GetByteArrayElements(key, 0);
+  leveldb::Slice keySlice(keyData, (size_t) env->GetArrayLength(key));
+
+  tx->Delete(keySlice);
+
+  env->ReleaseByteArrayElements(key, (jbyte *) keyData, 0);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_ncommit
+    (JNIEnv *env, jobject cself, jlong ntx, jboolean sync) {
+
+  Transaction *tx = (Transaction *) ntx;
+
+  leveldb::WriteOptions options;
+  options.sync = sync == JNI_TRUE;
+
+  bool conflict = false;
+  leveldb::Status status = tx->Commit(options, &conflict);
+
+  if (conflict) {
+    throwException(env,
+                   "com/edwardstock/leveldb/exception/LevelDBTransactionConflictException",
+                   "Keys read by the transaction have been changed since it began");
+    return;
+  }
+
+  throwExceptionFromStatus(env, status);
+}
+
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nclose
+    (JNIEnv *env, jobject cself, jlong ntx) {
+  if (ntx != 0) {
+    delete ((Transaction *) ntx);
+  }
+}
+
+} // extern C
@@ -0,0 +1,58 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_edwardstock_leveldb_implementation_NativeTransaction */
+
+#ifndef _Included_com_edwardstock_leveldb_implementation_NativeTransaction
+#define _Included_com_edwardstock_leveldb_implementation_NativeTransaction
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeTransaction
+ * Method:    nget
+ * Signature: (J[B)[B
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nget
+    (JNIEnv *, jobject, jlong, jbyteArray);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeTransaction
+ * Method:    nput
+ * Signature: (J[B[B)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nput
+    (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeTransaction
+ * Method:    ndelete
+ * Signature: (J[B)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_ndelete
+    (JNIEnv *, jobject, jlong, jbyteArray);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeTransaction
+ * Method:    ncommit
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_ncommit
+    (JNIEnv *, jobject, jlong, jboolean);
+
+/*
+ * Class:     com_edwardstock_leveldb_implementation_NativeTransaction
+ * Method:    nclose
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_edwardstock_leveldb_implementation_NativeTransaction_00024Companion_nclose
+    (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,62 @@
+#include "event_log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Longer messages are level summaries and file lists, none of which we parse.
+const size_t kMaxMessage = 256;
+
+} // namespace
+
+uint64_t EventLog::NowMicros() {
+  return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void EventLog::OnLog(const char *format, va_list ap) {
+  // Cheap check on the format first, most messages are of no interest.
+  if (strncmp(format, "Level-0 table #", 15) != 0 && strncmp(format, "Compact", 7) != 0) {
+    return;
+  }
+
+  char message[kMaxMessage];
+  vsnprintf(message, sizeof(message), format, ap);
+
+  unsigned long long table;
+  long long bytes;
+  int files0, level0, files1, level1;
+  char status[16];
+
+  if (sscanf(message, "Level-0 table #%llu: started", &table) == 1 && strstr(message, "started") != nullptr) {
+    flushStart_ = NowMicros();
+    events_->Push(DBEvent{DBEvent::FLUSH_STARTED, 0, (int64_t) table, 0, 0, 0});
+  } else if (sscanf(message, "Level-0 table #%llu: %lld bytes %15s", &table, &bytes, status) == 3) {
+    int64_t ok = strcmp(status, "OK") == 0 ? 1 : 0;
+    int64_t duration = (int64_t) (NowMicros() - flushStart_);
+    events_->Push(DBEvent{DBEvent::FLUSH_COMPLETED, 0, (int64_t) table, bytes, duration, ok});
+  } else if (sscanf(message, "Compacting %d@%d + %d@%d files", &files0, &level0, &files1, &level1) == 4) {
+    compactionLevel_ = level0;
+    compactionStart_ = NowMicros();
+    compactionBytesRead_ = env_->BackgroundBytesRead();
+    events_->Push(DBEvent{DBEvent::COMPACTION_STARTED, level0, files0, files1, 0, 0});
+  } else if (compactionLevel_ >= 0) {
+    bool succeeded = sscanf(message, "Compacted %d@%d + %d@%d files => %lld bytes",
+                            &files0, &level0, &files1, &level1, &bytes) == 5;
+    if (!succeeded && strncmp(message, "Compaction error: ", 18) != 0) {
+      return;
+    }
+
+    int64_t read = (int64_t) (env_->BackgroundBytesRead() - compactionBytesRead_);
+    int64_t duration = (int64_t) (NowMicros() - compactionStart_);
+    events_->Push(DBEvent{DBEvent::COMPACTION_COMPLETED,
+                          compactionLevel_,
+                          read,
+                          succeeded ? bytes : 0,
+                          duration,
+                          succeeded ? 1 : 0});
+    compactionLevel_ = -1;
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef LEVELDB_ANDROID_EVENT_LOG_H
+#define LEVELDB_ANDROID_EVENT_LOG_H
+
+#include <cstdarg>
+#include <cstdint>
+
+#include "binding_env.h"
+#include "event_queue.h"
+
+// Turns leveldb's info log into flush and compaction events. leveldb has no
+// listener API, but it logs the start and the end of every flush and
+// compaction, so this parses the formatted messages and times them.
+//
+// Flushes and compactions of a database all run on one background thread,
+// only Open() flushes on the caller's thread before that, so the state here
+// is never touched concurrently.
+class EventLog {
+ public:
+  EventLog(EventQueue *events, BindingEnv *env) : events_(events), env_(env) {}
+
+  void OnLog(const char *format, va_list ap);
+
+ private:
+  static uint64_t NowMicros();
+
+  EventQueue *const events_;
+  BindingEnv *const env_;
+
+  uint64_t flushStart_ = 0;
+
+  int compactionLevel_ = -1;
+  uint64_t compactionStart_ = 0;
+  uint64_t compactionBytesRead_ = 0;
+};
+
+#endif //LEVELDB_ANDROID_EVENT_LOG_H
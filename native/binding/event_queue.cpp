@@ -0,0 +1,127 @@
+#include "event_queue.h"
+
+#include <chrono>
+
+EventQueue::EventQueue(size_t capacity) {
+  if (capacity == 0) {
+    return;
+  }
+
+  size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  cells_.reset(new Cell[size]);
+  mask_ = size - 1;
+
+  for (size_t i = 0; i < size; i++) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+void EventQueue::Push(const DBEvent &event) {
+  if (!Enabled()) {
+    return;
+  }
+
+  size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+  Cell *cell;
+
+  for (;;) {
+    cell = &cells_[pos & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+    if (diff == 0) {
+      if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Full.
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = enqueuePos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->event = event;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  if (waiting_.load(std::memory_order_acquire)) {
+    nonEmpty_.notify_one();
+  }
+}
+
+bool EventQueue::TryPop(DBEvent *event) {
+  size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+  Cell *cell;
+
+  for (;;) {
+    cell = &cells_[pos & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+
+    if (diff == 0) {
+      if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Empty.
+      return false;
+    } else {
+      pos = dequeuePos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  *event = cell->event;
+  cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+bool EventQueue::Empty() const {
+  size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+  return cells_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+size_t EventQueue::Poll(DBEvent *out, size_t max, int timeoutMillis) {
+  if (!Enabled() || max == 0) {
+    return 0;
+  }
+
+  if (Empty() && dropped_.load(std::memory_order_relaxed) == 0 && timeoutMillis > 0) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiting_.store(true, std::memory_order_release);
+    // A push between Empty() and the wait isn't lost for longer than the timeout.
+    nonEmpty_.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [this] {
+      return !Empty() || stopped_.load(std::memory_order_acquire);
+    });
+    waiting_.store(false, std::memory_order_release);
+  }
+
+  size_t count = 0;
+
+  uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped != 0) {
+    out[count++] = DBEvent{DBEvent::DROPPED, 0, (int64_t) dropped, 0, 0, 0};
+  }
+
+  while (count < max && TryPop(&out[count])) {
+    count++;
+  }
+
+  return count;
+}
+
+void EventQueue::Stop() {
+  if (!Enabled()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_.store(true, std::memory_order_release);
+  }
+  nonEmpty_.notify_all();
+}
@@ -0,0 +1,96 @@
+#ifndef LEVELDB_ANDROID_EVENT_QUEUE_H
+#define LEVELDB_ANDROID_EVENT_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// Event of a database, delivered to the EventListener on the Kotlin side.
+// Fields are passed on as they are, their meaning depends on the type and
+// must match NativeEventDispatcher.
+struct DBEvent {
+  enum Type {
+    // a: table number
+    FLUSH_STARTED = 0,
+    // a: table number, b: table bytes, c: duration micros, d: 1 if succeeded
+    FLUSH_COMPLETED = 1,
+    // a: input files at `level`, b: input files at `level` + 1
+    COMPACTION_STARTED = 2,
+    // a: input bytes, b: output bytes, c: duration micros, d: 1 if succeeded
+    COMPACTION_COMPLETED = 3,
+    // a: 0 if the memtable is full, 1 if there are too many level-0 files
+    STALL_STARTED = 4,
+    // a: duration micros
+    STALL_ENDED = 5,
+    // a: number of events dropped because the queue was full
+    DROPPED = 6,
+  };
+
+  static const size_t kFields = 6;
+
+  int64_t type;
+  int64_t level;
+  int64_t a;
+  int64_t b;
+  int64_t c;
+  int64_t d;
+};
+
+// Bounded multi-producer queue of events (Vyukov's array-based queue).
+// Producers are leveldb's background thread and stalled writers, so Push()
+// never blocks or allocates: when the queue is full, the event is dropped
+// and counted. The consumer is the single dispatcher thread.
+class EventQueue {
+ public:
+  // Capacity is rounded up to a power of two, zero disables the queue.
+  explicit EventQueue(size_t capacity);
+
+  EventQueue(const EventQueue &) = delete;
+  EventQueue &operator=(const EventQueue &) = delete;
+
+  bool Enabled() const {
+    return cells_ != nullptr;
+  }
+
+  void Push(const DBEvent &event);
+
+  // Pops up to `max` events into `out`, waiting up to `timeoutMillis` for
+  // the first one. Reports dropped events as a DROPPED event first.
+  size_t Poll(DBEvent *out, size_t max, int timeoutMillis);
+
+  // Wakes up the consumer and makes Poll() return without waiting from now
+  // on, so that closing the database isn't held up by the dispatcher.
+  void Stop();
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    DBEvent event;
+  };
+
+  bool TryPop(DBEvent *event);
+  bool Empty() const;
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+
+  // Producers and the consumer each get their own cache line.
+  char pad0_[64];
+  std::atomic<size_t> enqueuePos_{0};
+  char pad1_[64];
+  std::atomic<size_t> dequeuePos_{0};
+  char pad2_[64];
+
+  std::atomic<uint64_t> dropped_{0};
+
+  // Only for the consumer to sleep on while the queue is empty. Producers
+  // notify without taking the mutex, and only when the consumer waits.
+  std::atomic<bool> waiting_{false};
+  std::atomic<bool> stopped_{false};
+  std::mutex mutex_;
+  std::condition_variable nonEmpty_;
+};
+
+#endif //LEVELDB_ANDROID_EVENT_QUEUE_H
@@ -0,0 +1,114 @@
+#include "iterator_pool.h"
+
+#include "secondary_index.h"
+
+IteratorPool::~IteratorPool() {
+  Clear();
+}
+
+leveldb::Iterator *IteratorPool::Acquire(leveldb::DB *db, uint64_t sequence) {
+  leveldb::Iterator *iterator = nullptr;
+  std::vector<Idle> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TakeStaleLocked(sequence, &stale);
+
+    if (!idle_.empty()) {
+      iterator = idle_.back().iterator;
+      idle_.pop_back();
+      idleCount_.store(idle_.size(), std::memory_order_relaxed);
+      borrowed_[iterator] = std::make_pair(sequence, generation_);
+    }
+  }
+  Delete(stale);
+
+  if (iterator != nullptr) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return iterator;
+  }
+
+  // Outside the lock, creating an iterator takes leveldb's mutex.
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  iterator = SecondaryIndexes::HideEntries(db->NewIterator(leveldb::ReadOptions()));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  borrowed_[iterator] = std::make_pair(sequence, generation_);
+  return iterator;
+}
+
+void IteratorPool::Release(leveldb::Iterator *iterator, uint64_t sequence) {
+  std::vector<Idle> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = borrowed_.find(iterator);
+    if (it != borrowed_.end()) {
+      std::pair<uint64_t, uint64_t> created = it->second;
+      borrowed_.erase(it);
+
+      if (created.first == sequence && created.second == generation_ && iterator->status().ok()) {
+        TakeStaleLocked(sequence, &stale);
+        if (idle_.size() < kMaxIdle) {
+          idle_.push_back({iterator, sequence});
+          idleCount_.store(idle_.size(), std::memory_order_relaxed);
+          iterator = nullptr;
+        }
+      }
+    }
+  }
+
+  Delete(stale);
+  delete iterator;
+}
+
+void IteratorPool::DropStale(uint64_t sequence) {
+  if (idleCount_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+
+  std::vector<Idle> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TakeStaleLocked(sequence, &stale);
+  }
+  Delete(stale);
+}
+
+void IteratorPool::Invalidate() {
+  std::vector<Idle> idle;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    idle.swap(idle_);
+    idleCount_.store(0, std::memory_order_relaxed);
+  }
+  Delete(idle);
+}
+
+void IteratorPool::Clear() {
+  std::vector<Idle> idle;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle.swap(idle_);
+    idleCount_.store(0, std::memory_order_relaxed);
+  }
+  Delete(idle);
+}
+
+void IteratorPool::TakeStaleLocked(uint64_t sequence, std::vector<Idle> *stale) {
+  size_t kept = 0;
+  for (const Idle &entry: idle_) {
+    if (entry.sequence == sequence) {
+      idle_[kept++] = entry;
+    } else {
+      stale->push_back(entry);
+    }
+  }
+  idle_.resize(kept);
+  idleCount_.store(kept, std::memory_order_relaxed);
+}
+
+void IteratorPool::Delete(const std::vector<Idle> &idle) {
+  for (const Idle &entry: idle) {
+    delete entry.iterator;
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef LEVELDB_ANDROID_ITERATOR_POOL_H
+#define LEVELDB_ANDROID_ITERATOR_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+
+// Reuses the iterators of reads without a snapshot. Creating one builds a
+// merging iterator over the memtables and all tables, which dominates short
+// range reads.
+//
+// leveldb iterators see the database as of their creation, and can't be
+// moved to a later state. So an idle iterator is reused only as long as
+// nothing has been written since it was created, i.e. the binding's
+// LastSequence() is still the same, which pays off for read-mostly
+// databases. Stale iterators are deleted as soon as a write makes them stale,
+// since they pin old memtables and tables. Like all iterators handed to
+// users, they skip index entries.
+class IteratorPool {
+ public:
+  // Idle iterators kept at most.
+  static const size_t kMaxIdle = 4;
+
+  IteratorPool() = default;
+  ~IteratorPool();
+
+  IteratorPool(const IteratorPool &) = delete;
+  IteratorPool &operator=(const IteratorPool &) = delete;
+
+  // Returns an idle iterator created at `sequence`, or a new one. Give it
+  // back with Release(), don't delete it.
+  leveldb::Iterator *Acquire(leveldb::DB *db, uint64_t sequence);
+
+  // Takes back an iterator from Acquire(), keeping it for reuse if it's
+  // still as of `sequence`. Unknown iterators are deleted.
+  void Release(leveldb::Iterator *iterator, uint64_t sequence);
+
+  // Deletes the idle iterators not created at `sequence`. Called after every
+  // write, cheap while there are none.
+  void DropStale(uint64_t sequence);
+
+  // Deletes the idle iterators and keeps the ones handed out from coming
+  // back, for writes that don't advance the sequence, like index rebuilds.
+  void Invalidate();
+
+  // Deletes the idle iterators. Must be called before the database is closed.
+  void Clear();
+
+  uint64_t Hits() const {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Misses() const {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+  size_t IdleCount() const {
+    return idleCount_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Idle {
+    leveldb::Iterator *iterator;
+    uint64_t sequence;
+  };
+
+  // Moves the idle iterators not created at `sequence` to `stale`, to be
+  // deleted outside the lock.
+  void TakeStaleLocked(uint64_t sequence, std::vector<Idle> *stale);
+
+  static void Delete(const std::vector<Idle> &idle);
+
+  std::mutex mutex_;
+  std::vector<Idle> idle_;
+  // Sequences and generations of the iterators handed out.
+  std::unordered_map<leveldb::Iterator *, std::pair<uint64_t, uint64_t>> borrowed_;
+  // Advanced by Invalidate().
+  uint64_t generation_ = 0;
+  // Size of idle_, read without the lock.
+  std::atomic<size_t> idleCount_{0};
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+#endif //LEVELDB_ANDROID_ITERATOR_POOL_H
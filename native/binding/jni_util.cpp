@@ -0,0 +1,31 @@
+#include "jni_util.h"
+
+void throwExceptionFromStatus(JNIEnv *env, leveldb::Status &status) {
+  if (status.ok()) {
+    return;
+  }
+
+  if (status.IsIOError()) {
+    throwException(env, "com/edwardstock/leveldb/exception/LevelDBIOException", status.ToString().data());
+  } else if (status.IsCorruption()) {
+    throwException(env, "com/edwardstock/leveldb/exception/LevelDBCorruptionException", status.ToString().data());
+  } else if (status.IsNotFound()) {
+    throwException(env, "com/edwardstock/leveldb/exception/LevelDBNotFoundException", status.ToString().data());
+  } else {
+    throwException(env, "com/edwardstock/leveldb/exception/LevelDBException", status.ToString().data());
+  }
+}
+
+void throwException(JNIEnv *env, const char *className, const char *message) {
+  jclass exceptionClass = env->FindClass(className);
+
+  env->ThrowNew(exceptionClass, message);
+}
+
+std::string stringFromJava(JNIEnv *env, jstring value) {
+  const char *chars = env->GetStringUTFChars(value, 0);
+  std::string result(chars);
+  env->ReleaseStringUTFChars(value, chars);
+
+  return result;
+}
@@ -0,0 +1,19 @@
+#ifndef LEVELDB_ANDROID_JNI_UTIL_H
+#define LEVELDB_ANDROID_JNI_UTIL_H
+
+#include <jni.h>
+#include <string>
+
+#include "leveldb/status.h"
+
+// Throws the appropriate Java exception for the given status. Make sure you
+// check IsNotFound() and similar possible non-exception statuses before calling
+// this. Please release all Java references before calling this.
+void throwExceptionFromStatus(JNIEnv *env, leveldb::Status &status);
+
+// Throws a new instance of the given com.edwardstock.leveldb.exception class.
+void throwException(JNIEnv *env, const char *className, const char *message);
+
+std::string stringFromJava(JNIEnv *env, jstring value);
+
+#endif //LEVELDB_ANDROID_JNI_UTIL_H
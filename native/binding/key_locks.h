@@ -0,0 +1,95 @@
+#ifndef LEVELDB_ANDROID_KEY_LOCKS_H
+#define LEVELDB_ANDROID_KEY_LOCKS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "leveldb/slice.h"
+
+// Lock striping over user keys. Every write through the binding locks the
+// stripes of the keys it touches, so read-modify-write operations (index
+// maintenance, transaction commits) see no concurrent change of those keys,
+// while unrelated keys never wait on each other.
+//
+// Each stripe also remembers the sequence of the last write to any of its
+// keys, which is what optimistic transactions validate their reads against.
+class KeyLocks {
+ public:
+  static const size_t kStripes = 1024;
+
+  KeyLocks() {
+    for (size_t i = 0; i < kStripes; i++) {
+      stripes_[i].version.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static size_t StripeOf(const leveldb::Slice &key) {
+    // FNV-1a, good enough to spread keys over the stripes.
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key.size(); i++) {
+      hash ^= (uint8_t) key[i];
+      hash *= 16777619u;
+    }
+    return hash % kStripes;
+  }
+
+  // Holds a set of stripes for the lifetime of the guard. Stripes are always
+  // taken in ascending order, so two guards can't deadlock.
+  class Guard {
+   public:
+    Guard(KeyLocks *locks, std::vector<size_t> stripes)
+        : locks_(locks), stripes_(std::move(stripes)) {
+      std::sort(stripes_.begin(), stripes_.end());
+      stripes_.erase(std::unique(stripes_.begin(), stripes_.end()), stripes_.end());
+
+      for (size_t stripe: stripes_) {
+        locks_->stripes_[stripe].mutex.lock();
+      }
+    }
+
+    ~Guard() {
+      for (auto it = stripes_.rbegin(); it != stripes_.rend(); ++it) {
+        locks_->stripes_[*it].mutex.unlock();
+      }
+    }
+
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+   private:
+    KeyLocks *locks_;
+    std::vector<size_t> stripes_;
+  };
+
+  // Stripes of all keys, for operations that must exclude every writer.
+  static std::vector<size_t> AllStripes() {
+    std::vector<size_t> stripes(kStripes);
+    for (size_t i = 0; i < kStripes; i++) {
+      stripes[i] = i;
+    }
+    return stripes;
+  }
+
+  // Sequence of the last write to the stripe. Only changed with the stripe locked.
+  uint64_t Version(size_t stripe) const {
+    return stripes_[stripe].version.load(std::memory_order_acquire);
+  }
+
+  void SetVersion(size_t stripe, uint64_t version) {
+    stripes_[stripe].version.store(version, std::memory_order_release);
+  }
+
+ private:
+  struct Stripe {
+    std::mutex mutex;
+    std::atomic<uint64_t> version;
+  };
+
+  Stripe stripes_[kStripes];
+};
+
+#endif //LEVELDB_ANDROID_KEY_LOCKS_H
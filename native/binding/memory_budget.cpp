@@ -0,0 +1,109 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+
+#include "leveldb/env.h"
+#include "ndb_holder.h"
+
+MemoryBudget *MemoryBudget::Default() {
+  static MemoryBudget *budget = new MemoryBudget();
+  return budget;
+}
+
+void MemoryBudget::Register(NDBHolder *holder) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  holders_.push_back(holder);
+}
+
+void MemoryBudget::Unregister(NDBHolder *holder) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  holders_.erase(std::remove(holders_.begin(), holders_.end(), holder), holders_.end());
+}
+
+uint64_t MemoryBudget::Usage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return UsageLocked();
+}
+
+uint64_t MemoryBudget::UsageLocked() {
+  uint64_t usage = 0;
+  for (NDBHolder *holder: holders_) {
+    MemoryUsage holderUsage;
+    holder->GetMemoryUsage(&holderUsage);
+    usage += holderUsage.Total();
+  }
+  return usage;
+}
+
+void MemoryBudget::OnWrite(uint64_t size) {
+  if (Limit() == 0) {
+    return;
+  }
+
+  uint64_t written = written_.fetch_add(size, std::memory_order_relaxed) + size;
+  if (written < kCheckInterval || enforcing_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  written_.store(0, std::memory_order_relaxed);
+
+  // Pruning caches and waiting for flushes would stall the writer that
+  // happened to cross the interval.
+  leveldb::Env::Default()->StartThread(&MemoryBudget::EnforceInBackground, this);
+}
+
+void MemoryBudget::EnforceInBackground(void *arg) {
+  MemoryBudget *budget = (MemoryBudget *) arg;
+  budget->Enforce();
+  budget->enforcing_.store(false, std::memory_order_release);
+}
+
+void MemoryBudget::Enforce() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EnforceLocked();
+}
+
+void MemoryBudget::EnforceLocked() {
+  uint64_t limit = Limit();
+  if (limit == 0 || UsageLocked() <= limit) {
+    return;
+  }
+  enforcements_.fetch_add(1, std::memory_order_relaxed);
+
+  for (NDBHolder *holder: holders_) {
+    holder->PruneCaches();
+  }
+
+  // Flushing a memtable frees it only once its table has been written, so
+  // the usage is measured again after every flush.
+  std::vector<NDBHolder *> flushed;
+  while (UsageLocked() > limit) {
+    NDBHolder *largest = nullptr;
+    uint64_t largestSize = kMinFlushSize - 1;
+
+    for (NDBHolder *holder: holders_) {
+      if (std::find(flushed.begin(), flushed.end(), holder) != flushed.end()) {
+        continue;
+      }
+      MemoryUsage usage;
+      holder->GetMemoryUsage(&usage);
+      if (usage.memtables > largestSize) {
+        largest = holder;
+        largestSize = usage.memtables;
+      }
+    }
+
+    if (largest == nullptr) {
+      break;
+    }
+    largest->FlushMemTable();
+    flushed.push_back(largest);
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void MemoryBudget::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (NDBHolder *holder: holders_) {
+    holder->PruneCaches();
+  }
+}
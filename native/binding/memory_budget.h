@@ -0,0 +1,109 @@
+#ifndef LEVELDB_ANDROID_MEMORY_BUDGET_H
+#define LEVELDB_ANDROID_MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class NDBHolder;
+
+// Native memory of a database, by component.
+struct MemoryUsage {
+  // Active and immutable memtables.
+  uint64_t memtables = 0;
+  // Charge of the block cache, including blocks pinned by iterators.
+  uint64_t blockCache = 0;
+  uint64_t rowCache = 0;
+  // Index blocks of the tables in leveldb's table cache.
+  uint64_t tableIndexes = 0;
+  // Estimate of the blocks held by iterators that bypass the block cache,
+  // plus the readahead windows of scans and compactions.
+  uint64_t iterators = 0;
+  // Files of in-memory databases.
+  uint64_t files = 0;
+
+  uint64_t Total() const {
+    return memtables + blockCache + rowCache + tableIndexes + iterators + files;
+  }
+};
+
+// Limit of the native memory of all databases open in the process. Writes
+// check it every kCheckInterval bytes. Over the limit, the caches of all
+// databases are pruned first and, if that's not enough, the largest
+// memtables are flushed early. Checks run on a thread of their own, one at a
+// time, so writers never wait for them.
+//
+// Neither frees pinned blocks, nor the files of in-memory databases, so the
+// usage can stay above the limit.
+class MemoryBudget {
+ public:
+  // Bytes written between checks, summed over all databases.
+  static const uint64_t kCheckInterval = 256 << 10;
+
+  // Memtables smaller than this are not worth flushing.
+  static const uint64_t kMinFlushSize = 256 << 10;
+
+  static MemoryBudget *Default();
+
+  MemoryBudget() = default;
+
+  MemoryBudget(const MemoryBudget &) = delete;
+  MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+  // Zero means no limit, which is the default.
+  void SetLimit(uint64_t limit) {
+    limit_.store(limit, std::memory_order_relaxed);
+  }
+
+  uint64_t Limit() const {
+    return limit_.load(std::memory_order_relaxed);
+  }
+
+  // Holders are registered while they are open. Unregister() waits for a
+  // running enforcement, so it must come before the holder is closed.
+  void Register(NDBHolder *holder);
+  void Unregister(NDBHolder *holder);
+
+  // Total usage of all open databases.
+  uint64_t Usage();
+
+  // Called before every write of `size` bytes. Starts a check when one is
+  // due, unless one is already running.
+  void OnWrite(uint64_t size);
+
+  // Enforces the limit now.
+  void Enforce();
+
+  // Prunes the caches of all databases regardless of the limit, e.g. when
+  // the system runs low on memory.
+  void Trim();
+
+  // How often the limit has been enforced since the process started, and
+  // how many memtables have been flushed for it.
+  uint64_t Enforcements() const {
+    return enforcements_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Flushes() const {
+    return flushes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  uint64_t UsageLocked();
+  void EnforceLocked();
+
+  static void EnforceInBackground(void *arg);
+
+  std::atomic<uint64_t> limit_{0};
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> enforcements_{0};
+  std::atomic<uint64_t> flushes_{0};
+  // Whether a check is running.
+  std::atomic<bool> enforcing_{false};
+
+  std::mutex mutex_;
+  std::vector<NDBHolder *> holders_;
+};
+
+#endif //LEVELDB_ANDROID_MEMORY_BUDGET_H
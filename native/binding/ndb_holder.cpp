@@ -0,0 +1,495 @@
+#include "ndb_holder.h"
+
+#include <algorithm>
+#include <string>
+
+#include "checkpoint.h"
+#include "primitive_codec.h"
+#include "readahead.h"
+
+namespace {
+
+// Imported records are written in batches of about this many bytes.
+const size_t kImportBatchSize = 4 << 20;
+
+void PutFixed32BE(std::string *out, uint32_t value) {
+  out->push_back((char) (value >> 24));
+  out->push_back((char) (value >> 16));
+  out->push_back((char) (value >> 8));
+  out->push_back((char) value);
+}
+
+} // namespace
+
+leveldb::Status NDBHolder::Write(const leveldb::WriteOptions &options, leveldb::WriteBatch *updates) {
+  BatchOps ops;
+  leveldb::Status status = updates->Iterate(&ops);
+  if (!status.ok()) {
+    return status;
+  }
+
+  BeforeWrite(updates->ApproximateSize());
+
+  KeyLocks::Guard guard(&locks_, ops.Stripes());
+
+  return WriteLocked(options, updates, ops);
+}
+
+leveldb::Status NDBHolder::TryWrite(const leveldb::WriteOptions &options,
+                                    leveldb::WriteBatch *updates,
+                                    uint64_t *retryAfterMillis) {
+  *retryAfterMillis = RetryAfterMillis(updates->ApproximateSize());
+  if (*retryAfterMillis != 0) {
+    return leveldb::Status::OK();
+  }
+
+  BatchOps ops;
+  leveldb::Status status = updates->Iterate(&ops);
+  if (!status.ok()) {
+    return status;
+  }
+
+  MemoryBudget::Default()->OnWrite(updates->ApproximateSize());
+
+  KeyLocks::Guard guard(&locks_, ops.Stripes());
+
+  return WriteLocked(options, updates, ops);
+}
+
+uint64_t NDBHolder::RetryAfterMillis(size_t size) {
+  // The cached count is only refreshed when leveldb logs, which may be a
+  // flush behind.
+  logger->pressure.RefreshL0Files();
+  uint64_t retryAfter = logger->pressure.RetryAfterMillis(db);
+
+  // leveldb makes the write wait if it doesn't fit into the memtable while
+  // the previous one is still being flushed, i.e. both are about full.
+  if (retryAfter == 0 && MemTableBytes() + size >= 2 * (uint64_t) writeBufferSize) {
+    retryAfter = 1;
+  }
+
+  if (retryAfter == 0 && throttleWrites_) {
+    uint64_t delay = logger->pressure.ThrottleDelayMicros(db);
+    retryAfter = delay == 0 ? 0 : (delay + 999) / 1000;
+  }
+
+  return retryAfter;
+}
+
+uint64_t NDBHolder::MemTableBytes() {
+  // Includes the block cache.
+  std::string value;
+  uint64_t total = 0;
+  if (db->GetProperty("leveldb.approximate-memory-usage", &value)) {
+    total = std::stoull(value);
+  }
+
+  uint64_t blockCache = cache->TotalCharge();
+  return total > blockCache ? total - blockCache : 0;
+}
+
+void NDBHolder::BeforeWrite(size_t size) {
+  MemoryBudget::Default()->OnWrite(size);
+
+  if (!throttleWrites_) {
+    return;
+  }
+
+  uint64_t delay = logger->pressure.ThrottleDelayMicros(db);
+  if (delay != 0) {
+    env->SleepForMicroseconds((int) delay);
+    logger->pressure.RecordThrottle(delay);
+  }
+}
+
+void NDBHolder::TrackIterator(leveldb::Iterator *iterator, bool fillCache) {
+  // Blocks of the others are in the block cache.
+  if (!fillCache) {
+    uncachedIterators_.fetch_add(1, std::memory_order_relaxed);
+    iterator->RegisterCleanup(&NDBHolder::ForgetIterator, &uncachedIterators_, nullptr);
+  }
+}
+
+void NDBHolder::ForgetIterator(void *arg1, void *arg2) {
+  ((std::atomic<uint64_t> *) arg1)->fetch_sub(1, std::memory_order_relaxed);
+}
+
+void NDBHolder::GetMemoryUsage(MemoryUsage *usage) {
+  usage->blockCache = cache->TotalCharge();
+  usage->memtables = MemTableBytes();
+  usage->rowCache = rowCache.Usage();
+  usage->tableIndexes = env->TableIndexBytes();
+  usage->files = env->MemoryUsage();
+
+  // An iterator holds a block of every table it's positioned in: one per
+  // level 0 table and one per deeper level with tables.
+  uint64_t iterators = uncachedIterators_.load(std::memory_order_relaxed);
+  usage->iterators = 0;
+  if (iterators != 0) {
+    std::string value;
+    uint64_t blocks = 0;
+    for (int level = 0; level < 7; level++) {
+      if (!db->GetProperty("leveldb.num-files-at-level" + std::to_string(level), &value)) {
+        break;
+      }
+      uint64_t files = std::stoull(value);
+      blocks += level == 0 ? files : std::min<uint64_t>(files, 1);
+    }
+    usage->iterators = iterators * blocks * blockSize;
+  }
+  usage->iterators += env->ReadaheadWindowBytes();
+}
+
+void NDBHolder::PruneCaches() {
+  cache->Prune();
+  rowCache.Prune();
+  iteratorPool.Clear();
+}
+
+void NDBHolder::FlushMemTable() {
+  // leveldb flushes the memtable before compacting a range. No key is less
+  // than the empty one, so this range overlaps with hardly any table.
+  leveldb::Slice empty;
+  db->CompactRange(&empty, &empty);
+}
+
+leveldb::Status NDBHolder::Get(const leveldb::ReadOptions &options, const leveldb::Slice &key, std::string *value) {
+  if (!rowCache.Enabled() || options.snapshot != nullptr || key.starts_with(SecondaryIndexes::kKeyPrefix)) {
+    return db->Get(options, key, value);
+  }
+
+  size_t stripe = KeyLocks::StripeOf(key);
+  uint64_t version = locks_.Version(stripe);
+
+  leveldb::Status status = db->Get(options, key, value);
+
+  if (status.ok() || status.IsNotFound()) {
+    rowCache.Insert(key, status.ok(), *value);
+
+    // A write that finished after our Get may have erased the key before we
+    // inserted it. Writers erase after bumping the version, so either we see
+    // the new version here, or their erase comes after our insert.
+    if (locks_.Version(stripe) != version) {
+      rowCache.Erase(key);
+    }
+  }
+
+  return status;
+}
+
+leveldb::Status NDBHolder::Commit(const leveldb::WriteOptions &options,
+                                  leveldb::WriteBatch *updates,
+                                  const std::vector<size_t> &readStripes,
+                                  uint64_t startSequence,
+                                  bool *conflict) {
+  *conflict = false;
+
+  BatchOps ops;
+  leveldb::Status status = updates->Iterate(&ops);
+  if (!status.ok() || ops.ops.empty()) {
+    // Reads of a read-only transaction all come from one snapshot, nothing to validate.
+    return status;
+  }
+
+  BeforeWrite(updates->ApproximateSize());
+
+  std::vector<size_t> stripes = ops.Stripes();
+  stripes.insert(stripes.end(), readStripes.begin(), readStripes.end());
+
+  KeyLocks::Guard guard(&locks_, std::move(stripes));
+
+  for (size_t stripe: readStripes) {
+    if (locks_.Version(stripe) > startSequence) {
+      *conflict = true;
+      return leveldb::Status::OK();
+    }
+  }
+
+  return WriteLocked(options, updates, ops);
+}
+
+leveldb::Status NDBHolder::IncrementLong(const leveldb::WriteOptions &options,
+                                         const leveldb::Slice &key,
+                                         int64_t delta,
+                                         int64_t *result) {
+  BeforeWrite(key.size() + PrimitiveCodec::kSize);
+
+  KeyLocks::Guard guard(&locks_, {KeyLocks::StripeOf(key)});
+
+  std::string current;
+  uint64_t value = 0;
+
+  leveldb::Status status = db->Get(leveldb::ReadOptions(), key, &current);
+  if (status.ok()) {
+    status = PrimitiveCodec::DecodeValue(current, &value);
+  } else if (status.IsNotFound()) {
+    status = leveldb::Status::OK();
+  }
+  if (!status.ok()) {
+    return status;
+  }
+
+  value += (uint64_t) delta;
+
+  char encoded[PrimitiveCodec::kSize];
+  PrimitiveCodec::EncodeFixed64(value, encoded);
+
+  leveldb::WriteBatch batch;
+  batch.Put(key, leveldb::Slice(encoded, sizeof(encoded)));
+
+  BatchOps ops;
+  batch.Iterate(&ops);
+
+  status = WriteLocked(options, &batch, ops);
+  if (status.ok()) {
+    *result = (int64_t) value;
+  }
+
+  return status;
+}
+
+leveldb::Status NDBHolder::RebuildIndex(const std::string &name, int threads) {
+  KeyLocks::Guard guard(&locks_, KeyLocks::AllStripes());
+
+  leveldb::Status status = indexes.Rebuild(db, name, threads);
+  // Index entries are written without advancing the sequence, the change
+  // feed has no records for them.
+  iteratorPool.Invalidate();
+  return status;
+}
+
+leveldb::Status NDBHolder::RegisterIndex(const IndexSpec &spec) {
+  // Writers that already loaded the old specs must not add entries the
+  // purge has passed.
+  KeyLocks::Guard guard(&locks_, KeyLocks::AllStripes());
+
+  leveldb::Status status = indexes.Register(db, spec);
+  iteratorPool.Invalidate();
+  return status;
+}
+
+leveldb::Status NDBHolder::DropIndex(const std::string &name, bool purge) {
+  KeyLocks::Guard guard(&locks_, KeyLocks::AllStripes());
+
+  leveldb::Status status = indexes.Drop(db, name, purge);
+  if (purge) {
+    iteratorPool.Invalidate();
+  }
+  return status;
+}
+
+leveldb::Status NDBHolder::Checkpoint(const std::string &target, bool incremental, uint64_t *sequence) {
+  BindingEnv::DeletionPause pause(env);
+
+  CheckpointFiles files;
+  leveldb::Status status;
+  {
+    // Writers only wait for the listing, not for the copy.
+    KeyLocks::Guard guard(&locks_, KeyLocks::AllStripes());
+
+    status = CaptureCheckpoint(env, path, &files);
+    *sequence = LastSequence();
+  }
+
+  if (!status.ok()) {
+    return status;
+  }
+
+  // In-memory databases are dumped to the filesystem.
+  if (env->InMemory()) {
+    return WriteCheckpoint(env, path, files, leveldb::Env::Default(), target, incremental, false);
+  }
+
+  return WriteCheckpoint(env, path, files, env, target, incremental, true);
+}
+
+leveldb::Status NDBHolder::Scan(const leveldb::Snapshot *snapshot,
+                                const leveldb::Slice *start,
+                                const leveldb::Slice *limit,
+                                size_t n,
+                                std::string *out) {
+  leveldb::Iterator *it;
+  if (snapshot == nullptr) {
+    it = AcquireIterator();
+  } else {
+    leveldb::ReadOptions readOptions;
+    readOptions.snapshot = snapshot;
+    it = SecondaryIndexes::HideEntries(db->NewIterator(readOptions));
+  }
+
+  if (start != nullptr) {
+    it->Seek(*start);
+  } else {
+    it->SeekToFirst();
+  }
+
+  for (size_t count = 0; count < n && it->Valid(); count++, it->Next()) {
+    leveldb::Slice key = it->key();
+    if (limit != nullptr && key.compare(*limit) >= 0) {
+      break;
+    }
+
+    leveldb::Slice value = it->value();
+    PutFixed32BE(out, (uint32_t) key.size());
+    out->append(key.data(), key.size());
+    PutFixed32BE(out, (uint32_t) value.size());
+    out->append(value.data(), value.size());
+  }
+
+  leveldb::Status status = it->status();
+
+  if (snapshot == nullptr) {
+    ReleaseIterator(it);
+  } else {
+    delete it;
+  }
+
+  return status;
+}
+
+leveldb::Status NDBHolder::Export(const leveldb::ReadOptions &options,
+                                  const leveldb::Slice *start,
+                                  const leveldb::Slice *limit,
+                                  bool compress,
+                                  TransferSink *sink,
+                                  TransferStats *stats) {
+  leveldb::ReadOptions readOptions = options;
+  readOptions.fill_cache = false;
+
+  std::unique_ptr<leveldb::Iterator> it(SecondaryIndexes::HideEntries(db->NewIterator(readOptions)));
+  if (env->Readahead() != 0) {
+    it.reset(new ScanIterator(it.release()));
+  }
+
+  TransferWriter writer(sink, compress);
+  leveldb::Status status = writer.Begin();
+
+  if (start != nullptr) {
+    it->Seek(*start);
+  } else {
+    it->SeekToFirst();
+  }
+
+  for (; status.ok() && it->Valid(); it->Next()) {
+    leveldb::Slice key = it->key();
+    if (limit != nullptr && key.compare(*limit) >= 0) {
+      break;
+    }
+
+    status = writer.Add(key, it->value());
+  }
+
+  if (status.ok()) {
+    status = it->status();
+  }
+  if (status.ok()) {
+    status = writer.Finish();
+  }
+  if (status.ok()) {
+    status = sink->Close();
+  }
+
+  *stats = writer.Stats();
+  return status;
+}
+
+leveldb::Status NDBHolder::Import(TransferSource *source,
+                                  const leveldb::WriteOptions &options,
+                                  TransferStats *stats) {
+  TransferReader reader(source);
+  leveldb::Status status = reader.Begin();
+
+  leveldb::WriteBatch batch;
+  leveldb::Slice key, value;
+  size_t pending = 0;
+  uint64_t skipped = 0;
+  bool done = false;
+
+  while (status.ok()) {
+    status = reader.Next(&key, &value, &done);
+    if (!status.ok() || done) {
+      break;
+    }
+
+    // Index entries of the source, e.g. from an export that didn't hide
+    // them. The indexes of this database get their own on the write.
+    if (key.starts_with(SecondaryIndexes::kKeyPrefix)) {
+      skipped++;
+      continue;
+    }
+
+    batch.Put(key, value);
+    pending++;
+
+    if (batch.ApproximateSize() >= kImportBatchSize) {
+      status = Write(options, &batch);
+      batch.Clear();
+      pending = 0;
+    }
+  }
+
+  if (status.ok() && pending > 0) {
+    status = Write(options, &batch);
+  }
+
+  *stats = reader.Stats();
+  stats->records -= skipped;
+  stats->skipped = skipped;
+  return status;
+}
+
+leveldb::Status NDBHolder::WriteLocked(const leveldb::WriteOptions &options,
+                                       leveldb::WriteBatch *updates,
+                                       const BatchOps &ops) {
+  if (env->OverMemoryLimit(updates->ApproximateSize())) {
+    return leveldb::Status::IOError("In-memory database is over its memory limit");
+  }
+
+  for (const BatchOps::Op &op: ops.ops) {
+    if (op.key.starts_with(SecondaryIndexes::kKeyPrefix)) {
+      return leveldb::Status::InvalidArgument("Keys starting with \\0\\0idx are reserved for secondary indexes");
+    }
+  }
+
+  leveldb::Status status;
+
+  if (indexes.Empty()) {
+    WritePressure::WriteScope scope(&logger->pressure);
+    status = db->Write(options, updates);
+  } else {
+    leveldb::WriteBatch indexed = *updates;
+    status = indexes.AddEntries(db, ops, &indexed);
+
+    if (status.ok()) {
+      WritePressure::WriteScope scope(&logger->pressure);
+      status = db->Write(options, &indexed);
+    }
+  }
+
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Only now, so that everything up to LastSequence() is visible to new snapshots.
+  uint64_t sequence;
+  if (feed.Enabled()) {
+    sequence = feed.Append(&sequence_, ops);
+  } else {
+    sequence = sequence_.fetch_add(ops.ops.size(), std::memory_order_acq_rel) + ops.ops.size();
+  }
+
+  for (const BatchOps::Op &op: ops.ops) {
+    locks_.SetVersion(KeyLocks::StripeOf(op.key), sequence);
+  }
+
+  // Idle iterators are as of an earlier sequence now, and pin the memtable.
+  iteratorPool.DropStale(sequence);
+
+  if (rowCache.Enabled()) {
+    for (const BatchOps::Op &op: ops.ops) {
+      rowCache.Erase(op.key);
+    }
+  }
+
+  return status;
+}
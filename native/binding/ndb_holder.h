@@ -0,0 +1,213 @@
+#ifndef LEVELDB_ANDROID_NDB_HOLDER_H
+#define LEVELDB_ANDROID_NDB_HOLDER_H
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/write_batch.h"
+#include "batch_ops.h"
+#include "binding_env.h"
+#include "change_feed.h"
+#include "event_log.h"
+#include "event_queue.h"
+#include "iterator_pool.h"
+#include "key_locks.h"
+#include "memory_budget.h"
+#include "row_cache.h"
+#include "secondary_index.h"
+#include "snapshot_registry.h"
+#include "transfer.h"
+#include "write_pressure.h"
+
+// Redirects leveldb's logging to the Android logger. leveldb's log is also
+// the only place it reports flushes and stalls, so they are tracked here.
+class AndroidLogger final: public leveldb::Logger {
+ public:
+  // Events are queued only if `eventQueueSize` is non-zero.
+  AndroidLogger(size_t eventQueueSize, BindingEnv *env)
+      : events(eventQueueSize),
+        eventLog(&events, env),
+        pressure(&events) {}
+
+  void Logv(const char *format, va_list ap) override {
+    pressure.OnLog(format);
+    if (events.Enabled()) {
+      va_list copy;
+      va_copy(copy, ap);
+      eventLog.OnLog(format, copy);
+      va_end(copy);
+    }
+//        __android_log_vprint(ANDROID_LOG_INFO, "com.edwardstock.leveldb:N", format, ap);
+  }
+
+  EventQueue events;
+  EventLog eventLog;
+  WritePressure pressure;
+};
+
+// Holds references to heap-allocated native objects so that they can be
+// closed in Java_com_edwardstock_leveldb_implementation_NativeLevelDB_nclose.
+class NDBHolder {
+ public:
+  NDBHolder(const std::string &lpath,
+            leveldb::DB *ldb,
+            AndroidLogger *llogger,
+            leveldb::Cache *lcache,
+            size_t lblockSize,
+            size_t lwriteBufferSize,
+            BindingEnv *lenv,
+            size_t changeFeedSize,
+            size_t rowCacheSize,
+            bool throttleWrites)
+      : path(lpath),
+        db(ldb),
+        logger(llogger),
+        cache(lcache),
+        blockSize(lblockSize),
+        writeBufferSize(lwriteBufferSize),
+        env(lenv),
+        feed(changeFeedSize),
+        rowCache(rowCacheSize),
+        snapshots(lenv),
+        throttleWrites_(throttleWrites) {}
+
+  std::string path;
+
+  leveldb::DB *db;
+  AndroidLogger *logger;
+
+  leveldb::Cache *cache;
+  const size_t blockSize;
+  const size_t writeBufferSize;
+  BindingEnv *env;
+
+  SecondaryIndexes indexes;
+  ChangeFeed feed;
+  RowCache rowCache;
+  SnapshotRegistry snapshots;
+  IteratorPool iteratorPool;
+
+  // Reads a record through the row cache, filling it on a miss. Reads from
+  // snapshots bypass the cache. Check rowCache.Lookup() first.
+  leveldb::Status Get(const leveldb::ReadOptions &options, const leveldb::Slice &key, std::string *value);
+
+  // Every write through the binding goes here: locks the keys, adds index
+  // entries and advances the sequence. Writes to in-memory databases over
+  // their memory limit fail with an IOError.
+  leveldb::Status Write(const leveldb::WriteOptions &options, leveldb::WriteBatch *updates);
+
+  // Writes `updates` only if leveldb wouldn't make the write wait, otherwise
+  // sets `retryAfterMillis` to a hint when to try again and writes nothing.
+  // Best effort: the checks right before the write can't see a flush or
+  // compaction that leveldb starts in between.
+  leveldb::Status TryWrite(const leveldb::WriteOptions &options,
+                           leveldb::WriteBatch *updates,
+                           uint64_t *retryAfterMillis);
+
+  // Writes `updates` only if none of the `readStripes` has been written after
+  // `startSequence`, otherwise sets `conflict` and writes nothing.
+  leveldb::Status Commit(const leveldb::WriteOptions &options,
+                         leveldb::WriteBatch *updates,
+                         const std::vector<size_t> &readStripes,
+                         uint64_t startSequence,
+                         bool *conflict);
+
+  // Adds `delta` to the long stored under `key`, missing counts as zero, and
+  // sets `result` to the sum. Overflow wraps around.
+  leveldb::Status IncrementLong(const leveldb::WriteOptions &options,
+                                const leveldb::Slice &key,
+                                int64_t delta,
+                                int64_t *result);
+
+  leveldb::Status RegisterIndex(const IndexSpec &spec);
+
+  leveldb::Status RebuildIndex(const std::string &name, int threads);
+
+  leveldb::Status DropIndex(const std::string &name, bool purge);
+
+  // Writes a consistent copy of the database to `target` without stopping
+  // it, see WriteCheckpoint(). Sets `sequence` to the LastSequence() the
+  // checkpoint contains. Copies of in-memory databases go to the filesystem.
+  leveldb::Status Checkpoint(const std::string &target, bool incremental, uint64_t *sequence);
+
+  // Streams the records in [start, limit) to `sink`, see transfer.h. Null
+  // bounds are open. Index entries are left out, the importing database
+  // maintains its own.
+  leveldb::Status Export(const leveldb::ReadOptions &options,
+                         const leveldb::Slice *start,
+                         const leveldb::Slice *limit,
+                         bool compress,
+                         TransferSink *sink,
+                         TransferStats *stats);
+
+  // Writes the records of a stream from Export() in large batches, through
+  // Write(). On an error, the batches written so far stay.
+  leveldb::Status Import(TransferSource *source, const leveldb::WriteOptions &options, TransferStats *stats);
+
+  // Iterators without a snapshot from the pool, see IteratorPool.
+  leveldb::Iterator *AcquireIterator() {
+    return iteratorPool.Acquire(db, LastSequence());
+  }
+
+  void ReleaseIterator(leveldb::Iterator *iterator) {
+    iteratorPool.Release(iterator, LastSequence());
+  }
+
+  // Appends up to `n` records from `start` on, up to `limit` exclusive, to
+  // `out`: big-endian 32 bit key length, key, value length and value each.
+  // Null bounds are open. Reads without a snapshot use a pooled iterator.
+  leveldb::Status Scan(const leveldb::Snapshot *snapshot,
+                       const leveldb::Slice *start,
+                       const leveldb::Slice *limit,
+                       size_t n,
+                       std::string *out);
+
+  // Counts the iterator among the open ones until it's deleted.
+  void TrackIterator(leveldb::Iterator *iterator, bool fillCache);
+
+  void GetMemoryUsage(MemoryUsage *usage);
+
+  // Drops the entries of the block and row caches that aren't in use, and
+  // the idle pooled iterators.
+  void PruneCaches();
+
+  // Writes the memtable to a table now, waiting until it's written.
+  void FlushMemTable();
+
+  // Sequence of the last write through the binding. Counts records, not
+  // batches. It's not LevelDB's internal sequence, which is not public.
+  uint64_t LastSequence() const {
+    return sequence_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // Sleeps for the throttle delay, if the throttle is on, and has the
+  // process memory budget enforced, if due.
+  void BeforeWrite(size_t size);
+
+  // Zero if a write of `size` bytes would go through without waiting, as
+  // far as can be told right now, otherwise a hint when to try again.
+  uint64_t RetryAfterMillis(size_t size);
+
+  // Memory of the memtable and the one being flushed, if any.
+  uint64_t MemTableBytes();
+
+  static void ForgetIterator(void *arg1, void *arg2);
+
+  leveldb::Status WriteLocked(const leveldb::WriteOptions &options,
+                              leveldb::WriteBatch *updates,
+                              const BatchOps &ops);
+
+  KeyLocks locks_;
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<uint64_t> uncachedIterators_{0};
+  const bool throttleWrites_;
+};
+
+#endif //LEVELDB_ANDROID_NDB_HOLDER_H
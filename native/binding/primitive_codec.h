@@ -0,0 +1,71 @@
+#ifndef LEVELDB_ANDROID_PRIMITIVE_CODEC_H
+#define LEVELDB_ANDROID_PRIMITIVE_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+// Fixed encodings of the primitive entry points (NativeLevelDB.putLong and
+// friends). Everything is written as 8 bytes, big-endian. Must match Bytes
+// on the Kotlin side.
+class PrimitiveCodec {
+ public:
+  static const size_t kSize = 8;
+
+  static void EncodeFixed64(uint64_t value, char *out) {
+    for (int i = 7; i >= 0; i--) {
+      out[i] = (char) value;
+      value >>= 8;
+    }
+  }
+
+  static uint64_t DecodeFixed64(const char *in) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < kSize; i++) {
+      value = (value << 8) | (uint8_t) in[i];
+    }
+    return value;
+  }
+
+  // Long keys have the sign bit flipped, so that they sort numerically under
+  // the bytewise comparator.
+  static void EncodeLongKey(int64_t key, char *out) {
+    EncodeFixed64((uint64_t) key ^ kSignBit, out);
+  }
+
+  static uint64_t FromDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  static double ToDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // Decodes a stored value: big-endian two's complement of 1 to 8 bytes,
+  // sign-extended. The primitive entry points write 8 bytes, LongConverter
+  // writes the shortest form (BigInteger.toByteArray()).
+  static leveldb::Status DecodeValue(const leveldb::Slice &value, uint64_t *out) {
+    if (value.empty() || value.size() > kSize) {
+      return leveldb::Status::InvalidArgument("Value is not a primitive, its size is not 1 to 8 bytes");
+    }
+
+    uint64_t decoded = (int8_t) value[0] < 0 ? ~0ull : 0;
+    for (size_t i = 0; i < value.size(); i++) {
+      decoded = (decoded << 8) | (uint8_t) value[i];
+    }
+
+    *out = decoded;
+    return leveldb::Status::OK();
+  }
+
+ private:
+  static const uint64_t kSignBit = 1ull << 63;
+};
+
+#endif //LEVELDB_ANDROID_PRIMITIVE_CODEC_H
@@ -0,0 +1,207 @@
+#include "readahead.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+thread_local ReadaheadWindows *currentWindows = nullptr;
+
+#ifndef _WIN32
+
+std::atomic<uint64_t> nextFileId{1};
+
+leveldb::Status ReadError(const std::string &fname, int error) {
+  return leveldb::Status::IOError(fname, strerror(error));
+}
+
+class ReadaheadFile final: public leveldb::RandomAccessFile {
+  typedef ReadaheadWindows::Window Window;
+
+ public:
+  ReadaheadFile(const std::string &fname,
+                int fd,
+                size_t readahead,
+                std::atomic<uint64_t> *bytesRead,
+                std::atomic<uint64_t> *windowBytes)
+      : fname_(fname),
+        fd_(fd),
+        readahead_(readahead),
+        bytesRead_(bytesRead),
+        windowBytes_(windowBytes),
+        id_(nextFileId.fetch_add(1)) {}
+
+  ~ReadaheadFile() override {
+    close(fd_);
+  }
+
+  leveldb::Status Read(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const override {
+    ReadaheadWindows *windows = ScanScope::Current();
+    if (windows == nullptr || n >= readahead_) {
+      return ReadDirect(offset, n, result, scratch);
+    }
+
+    Window *window = windows->Find(id_);
+    if (window == nullptr || offset < window->offset || offset + n > window->offset + window->data.size()) {
+      if (window == nullptr) {
+        window = windows->New();
+      }
+      leveldb::Status status = Fill(window, offset);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
+    size_t start = (size_t) (offset - window->offset);
+    size_t available = std::min(n, window->data.size() - std::min(start, window->data.size()));
+    if (available > 0) {
+      memcpy(scratch, window->data.data() + start, available);
+    }
+
+    *result = leveldb::Slice(scratch, available);
+    return leveldb::Status::OK();
+  }
+
+ private:
+  leveldb::Status ReadDirect(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const {
+    ssize_t read = ::pread(fd_, scratch, n, (off_t) offset);
+    if (read < 0) {
+      *result = leveldb::Slice(scratch, 0);
+      return ReadError(fname_, errno);
+    }
+
+    bytesRead_->fetch_add((uint64_t) read, std::memory_order_relaxed);
+    *result = leveldb::Slice(scratch, (size_t) read);
+    return leveldb::Status::OK();
+  }
+
+  leveldb::Status Fill(Window *window, uint64_t offset) const {
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (!advised_.exchange(true, std::memory_order_relaxed)) {
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    window->file = 0;
+    window->data.resize(readahead_);
+
+    if (window->usage != windowBytes_ || window->charged != window->data.capacity()) {
+      if (window->usage != nullptr) {
+        window->usage->fetch_sub(window->charged, std::memory_order_relaxed);
+      }
+      window->usage = windowBytes_;
+      window->charged = window->data.capacity();
+      windowBytes_->fetch_add(window->charged, std::memory_order_relaxed);
+    }
+
+    ssize_t read = ::pread(fd_, &window->data[0], readahead_, (off_t) offset);
+    if (read < 0) {
+      window->data.clear();
+      return ReadError(fname_, errno);
+    }
+
+    bytesRead_->fetch_add((uint64_t) read, std::memory_order_relaxed);
+    window->data.resize((size_t) read);
+    window->file = id_;
+    window->offset = offset;
+
+#ifdef POSIX_FADV_WILLNEED
+    // Let the kernel fetch the next window while this one is being consumed.
+    if ((size_t) read == readahead_) {
+      posix_fadvise(fd_, (off_t) (offset + readahead_), (off_t) readahead_, POSIX_FADV_WILLNEED);
+    }
+#endif
+
+    return leveldb::Status::OK();
+  }
+
+  const std::string fname_;
+  const int fd_;
+  const size_t readahead_;
+  std::atomic<uint64_t> *bytesRead_;
+  std::atomic<uint64_t> *windowBytes_;
+  // Identifies the file in the windows, pointers can be reused.
+  const uint64_t id_;
+  mutable std::atomic<bool> advised_{false};
+};
+
+#endif // _WIN32
+
+} // namespace
+
+ReadaheadWindows::~ReadaheadWindows() {
+  for (const Window &window: windows_) {
+    if (window.usage != nullptr) {
+      window.usage->fetch_sub(window.charged, std::memory_order_relaxed);
+    }
+  }
+}
+
+ReadaheadWindows::Window *ReadaheadWindows::Find(uint64_t file) {
+  for (Window &window: windows_) {
+    if (window.file == file) {
+      window.lastUse = ++clock_;
+      return &window;
+    }
+  }
+  return nullptr;
+}
+
+ReadaheadWindows::Window *ReadaheadWindows::New() {
+  Window *window;
+  if (windows_.size() < kMaxWindows) {
+    windows_.emplace_back();
+    window = &windows_.back();
+  } else {
+    window = &*std::min_element(windows_.begin(), windows_.end(), [](const Window &a, const Window &b) {
+      return a.lastUse < b.lastUse;
+    });
+  }
+  window->file = 0;
+  window->lastUse = ++clock_;
+  return window;
+}
+
+ScanScope::ScanScope(ReadaheadWindows *windows) : previous_(currentWindows) {
+  currentWindows = windows;
+}
+
+ScanScope::~ScanScope() {
+  currentWindows = previous_;
+}
+
+ReadaheadWindows *ScanScope::Current() {
+  return currentWindows;
+}
+
+leveldb::Status NewReadaheadFile(const std::string &fname,
+                                 size_t readahead,
+                                 std::atomic<uint64_t> *bytesRead,
+                                 std::atomic<uint64_t> *windowBytes,
+                                 leveldb::RandomAccessFile **result) {
+#ifdef _WIN32
+  // No pread(2), tables are read the default way.
+  return leveldb::Env::Default()->NewRandomAccessFile(fname, result);
+#else
+  int fd = ::open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *result = nullptr;
+    if (errno == ENOENT) {
+      return leveldb::Status::NotFound(fname, strerror(errno));
+    }
+    return ReadError(fname, errno);
+  }
+
+  *result = new ReadaheadFile(fname, fd, readahead, bytesRead, windowBytes);
+  return leveldb::Status::OK();
+#endif
+}
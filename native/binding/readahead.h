@@ -0,0 +1,135 @@
+#ifndef LEVELDB_ANDROID_READAHEAD_H
+#define LEVELDB_ANDROID_READAHEAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+
+// Readahead windows of one scan or compaction. Scans merge the tables of all
+// levels and compactions the tables of two, switching between them from
+// block to block, so there is a window per file, for up to kMaxWindows
+// files. The memory is given back when the windows are destroyed.
+class ReadaheadWindows {
+ public:
+  static const size_t kMaxWindows = 8;
+
+  struct Window {
+    uint64_t file = 0;
+    uint64_t offset = 0;
+    uint64_t lastUse = 0;
+    std::string data;
+    // Where the bytes allocated for `data` are counted, and how many.
+    std::atomic<uint64_t> *usage = nullptr;
+    size_t charged = 0;
+  };
+
+  ReadaheadWindows() = default;
+  ~ReadaheadWindows();
+
+  ReadaheadWindows(const ReadaheadWindows &) = delete;
+  ReadaheadWindows &operator=(const ReadaheadWindows &) = delete;
+
+  // Window of `file`, or null if there is none.
+  Window *Find(uint64_t file);
+
+  // A new window, or the least recently used one once there are kMaxWindows.
+  Window *New();
+
+ private:
+  std::vector<Window> windows_;
+  uint64_t clock_ = 0;
+};
+
+// Marks the current thread as scanning: while a scope is alive, table reads
+// of the thread are served from `windows` instead of one block at a time.
+class ScanScope {
+ public:
+  explicit ScanScope(ReadaheadWindows *windows);
+  ~ScanScope();
+
+  ScanScope(const ScanScope &) = delete;
+  ScanScope &operator=(const ScanScope &) = delete;
+
+  // Windows of the innermost scope of the current thread, or null.
+  static ReadaheadWindows *Current();
+
+ private:
+  ReadaheadWindows *previous_;
+};
+
+// Runs every positioning call of the wrapped iterator in a ScanScope. Used
+// for iterators that don't fill the block cache, which are the scans. The
+// windows live as long as the iterator, so consecutive calls continue where
+// the previous one stopped.
+class ScanIterator final: public leveldb::Iterator {
+ public:
+  explicit ScanIterator(leveldb::Iterator *it) : it_(it) {}
+
+  ~ScanIterator() override {
+    delete it_;
+  }
+
+  bool Valid() const override {
+    return it_->Valid();
+  }
+
+  void SeekToFirst() override {
+    ScanScope scope(&windows_);
+    it_->SeekToFirst();
+  }
+
+  void SeekToLast() override {
+    ScanScope scope(&windows_);
+    it_->SeekToLast();
+  }
+
+  void Seek(const leveldb::Slice &target) override {
+    ScanScope scope(&windows_);
+    it_->Seek(target);
+  }
+
+  void Next() override {
+    ScanScope scope(&windows_);
+    it_->Next();
+  }
+
+  void Prev() override {
+    ScanScope scope(&windows_);
+    it_->Prev();
+  }
+
+  leveldb::Slice key() const override {
+    return it_->key();
+  }
+
+  leveldb::Slice value() const override {
+    return it_->value();
+  }
+
+  leveldb::Status status() const override {
+    return it_->status();
+  }
+
+ private:
+  leveldb::Iterator *it_;
+  ReadaheadWindows windows_;
+};
+
+// Opens a table file read with pread(2). Reads made in a ScanScope fill a
+// window of `readahead` bytes, advise the kernel that the file is read
+// sequentially and that the following window will be needed soon. Bytes
+// read from the file, windows included, are added to `bytesRead`, bytes of
+// the windows it fills to `windowBytes` for as long as they are kept. On
+// Windows, opens the file the default way.
+leveldb::Status NewReadaheadFile(const std::string &fname,
+                                 size_t readahead,
+                                 std::atomic<uint64_t> *bytesRead,
+                                 std::atomic<uint64_t> *windowBytes,
+                                 leveldb::RandomAccessFile **result);
+
+#endif //LEVELDB_ANDROID_READAHEAD_H
@@ -0,0 +1,65 @@
+#include "row_cache.h"
+
+RowCache::RowCache(size_t capacity)
+    : capacity_(capacity), cache_(capacity == 0 ? nullptr : leveldb::NewLRUCache(capacity)) {}
+
+RowCache::~RowCache() {
+  delete cache_;
+}
+
+RowCache::Handle::~Handle() {
+  if (handle_ != nullptr) {
+    cache_->Release(handle_);
+  }
+}
+
+bool RowCache::Handle::Found() const {
+  return ((Row *) cache_->Value(handle_))->found;
+}
+
+leveldb::Slice RowCache::Handle::Value() const {
+  return ((Row *) cache_->Value(handle_))->value;
+}
+
+bool RowCache::Lookup(const leveldb::Slice &key, Handle *handle) {
+  leveldb::Cache::Handle *found = cache_->Lookup(key);
+
+  if (found == nullptr) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  handle->cache_ = cache_;
+  handle->handle_ = found;
+  return true;
+}
+
+void RowCache::Insert(const leveldb::Slice &key, bool found, const leveldb::Slice &value) {
+  Row *row = new Row();
+  row->found = found;
+  if (found) {
+    row->value.assign(value.data(), value.size());
+  }
+
+  size_t charge = sizeof(Row) + key.size() + row->value.size();
+  cache_->Release(cache_->Insert(key, row, charge, &RowCache::DeleteRow));
+}
+
+void RowCache::Erase(const leveldb::Slice &key) {
+  cache_->Erase(key);
+}
+
+void RowCache::Prune() {
+  if (cache_ != nullptr) {
+    cache_->Prune();
+  }
+}
+
+size_t RowCache::Usage() const {
+  return cache_ == nullptr ? 0 : cache_->TotalCharge();
+}
+
+void RowCache::DeleteRow(const leveldb::Slice &key, void *value) {
+  delete (Row *) value;
+}
@@ -0,0 +1,86 @@
+#ifndef LEVELDB_ANDROID_ROW_CACHE_H
+#define LEVELDB_ANDROID_ROW_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "leveldb/cache.h"
+#include "leveldb/slice.h"
+
+// Cache of whole records by user key, in front of the LSM. Backed by
+// leveldb's sharded LRU cache, so lookups of different keys rarely contend.
+// Misses are cached too, as records that are not found.
+//
+// The cache itself doesn't know about writes: NDBHolder erases every written
+// key and makes sure a concurrent read never leaves a stale record behind.
+class RowCache {
+ public:
+  // Zero capacity disables the cache.
+  explicit RowCache(size_t capacity);
+  ~RowCache();
+
+  RowCache(const RowCache &) = delete;
+  RowCache &operator=(const RowCache &) = delete;
+
+  bool Enabled() const {
+    return cache_ != nullptr;
+  }
+
+  // Pins a cached record while it is being read.
+  class Handle {
+   public:
+    Handle() = default;
+    ~Handle();
+
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+
+    // Whether the record exists. A cached miss has no value.
+    bool Found() const;
+    leveldb::Slice Value() const;
+
+   private:
+    friend class RowCache;
+
+    leveldb::Cache *cache_ = nullptr;
+    leveldb::Cache::Handle *handle_ = nullptr;
+  };
+
+  bool Lookup(const leveldb::Slice &key, Handle *handle);
+  void Insert(const leveldb::Slice &key, bool found, const leveldb::Slice &value);
+  void Erase(const leveldb::Slice &key);
+
+  // Drops the records that aren't being read.
+  void Prune();
+
+  uint64_t Hits() const {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Misses() const {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+  size_t Usage() const;
+
+  size_t Capacity() const {
+    return capacity_;
+  }
+
+ private:
+  struct Row {
+    bool found;
+    std::string value;
+  };
+
+  static void DeleteRow(const leveldb::Slice &key, void *value);
+
+  const size_t capacity_;
+  leveldb::Cache *cache_;
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+#endif //LEVELDB_ANDROID_ROW_CACHE_H
@@ -0,0 +1,485 @@
+#include "secondary_index.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "leveldb/iterator.h"
+
+const leveldb::Slice SecondaryIndexes::kKeyPrefix("\0\0idx", 5);
+const leveldb::Slice SecondaryIndexes::kKeyPrefixEnd("\0\0idy", 5);
+
+namespace {
+
+// Number of records a rebuild worker indexes per write.
+const size_t kRebuildChunkSize = 1000;
+
+// Steps over the index entries, which are all in [kKeyPrefix, kKeyPrefixEnd).
+class EntryHidingIterator final: public leveldb::Iterator {
+ public:
+  explicit EntryHidingIterator(leveldb::Iterator *iterator) : iterator_(iterator) {}
+
+  bool Valid() const override {
+    return iterator_->Valid();
+  }
+
+  void SeekToFirst() override {
+    iterator_->SeekToFirst();
+    SkipForward();
+  }
+
+  void SeekToLast() override {
+    iterator_->SeekToLast();
+    SkipBackward();
+  }
+
+  void Seek(const leveldb::Slice &target) override {
+    iterator_->Seek(target);
+    SkipForward();
+  }
+
+  void Next() override {
+    iterator_->Next();
+    SkipForward();
+  }
+
+  void Prev() override {
+    iterator_->Prev();
+    SkipBackward();
+  }
+
+  leveldb::Slice key() const override {
+    return iterator_->key();
+  }
+
+  leveldb::Slice value() const override {
+    return iterator_->value();
+  }
+
+  leveldb::Status status() const override {
+    return iterator_->status();
+  }
+
+ private:
+  bool AtEntry() const {
+    return iterator_->Valid() && iterator_->key().starts_with(SecondaryIndexes::kKeyPrefix);
+  }
+
+  void SkipForward() {
+    if (AtEntry()) {
+      iterator_->Seek(SecondaryIndexes::kKeyPrefixEnd);
+    }
+  }
+
+  void SkipBackward() {
+    if (AtEntry()) {
+      // Lands on the first entry, the record before it is the one wanted.
+      iterator_->Seek(SecondaryIndexes::kKeyPrefix);
+      iterator_->Prev();
+    }
+  }
+
+  std::unique_ptr<leveldb::Iterator> iterator_;
+};
+
+} // namespace
+
+leveldb::Iterator *SecondaryIndexes::HideEntries(leveldb::Iterator *iterator) {
+  return new EntryHidingIterator(iterator);
+}
+
+bool IndexSpec::Extract(const leveldb::Slice &key, const leveldb::Slice &value, std::string *out) const {
+  const leveldb::Slice &source = (type == KEY_RANGE || type == KEY_FIELD) ? key : value;
+
+  if (type == VALUE_RANGE || type == KEY_RANGE) {
+    if (offset < 0 || (size_t) offset > source.size()) {
+      return false;
+    }
+
+    size_t available = source.size() - (size_t) offset;
+    if (length >= 0 && (size_t) length > available) {
+      return false;
+    }
+
+    out->assign(source.data() + offset, length < 0 ? available : (size_t) length);
+    return true;
+  }
+
+  int field = 0;
+  size_t start = 0;
+  for (size_t i = 0; i <= source.size(); i++) {
+    if (i == source.size() || source[i] == delimiter) {
+      if (field == offset) {
+        out->assign(source.data() + start, i - start);
+        return true;
+      }
+      field++;
+      start = i + 1;
+    }
+  }
+
+  return false;
+}
+
+std::shared_ptr<const SecondaryIndexes::Specs> SecondaryIndexes::CurrentSpecs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return specs_;
+}
+
+bool SecondaryIndexes::FindSpec(const std::string &name, IndexSpec *spec) const {
+  std::shared_ptr<const Specs> specs = CurrentSpecs();
+
+  for (const IndexSpec &candidate: *specs) {
+    if (candidate.name == name) {
+      *spec = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string SecondaryIndexes::NamePrefix(const std::string &name) {
+  std::string prefix = kKeyPrefix.ToString();
+  prefix.append(name);
+  prefix.push_back('\0');
+  return prefix;
+}
+
+std::string SecondaryIndexes::EntryPrefix(const std::string &name, const leveldb::Slice &indexKey) {
+  std::string prefix = NamePrefix(name);
+
+  // Fixed size length, so that "ab" + "c..." and "a" + "bc..." never share a prefix.
+  uint32_t length = (uint32_t) indexKey.size();
+  prefix.push_back((char) (length >> 24));
+  prefix.push_back((char) (length >> 16));
+  prefix.push_back((char) (length >> 8));
+  prefix.push_back((char) length);
+
+  prefix.append(indexKey.data(), indexKey.size());
+  return prefix;
+}
+
+leveldb::Status SecondaryIndexes::Register(leveldb::DB *db, const IndexSpec &spec) {
+  bool replaced = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto specs = std::make_shared<Specs>(*specs_);
+    auto existing = std::find_if(specs->begin(), specs->end(), [&spec](const IndexSpec &candidate) {
+      return candidate.name == spec.name;
+    });
+
+    if (existing != specs->end()) {
+      if (*existing == spec) {
+        return leveldb::Status::OK();
+      }
+      *existing = spec;
+      replaced = true;
+    } else {
+      specs->push_back(spec);
+    }
+
+    count_.store(specs->size(), std::memory_order_release);
+    specs_ = specs;
+  }
+
+  if (!replaced) {
+    return leveldb::Status::OK();
+  }
+
+  // The old entries were keyed by the old extractor, AddEntries() would not
+  // find them to delete.
+  return Purge(db, spec.name);
+}
+
+leveldb::Status SecondaryIndexes::Drop(leveldb::DB *db, const std::string &name, bool purge) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto specs = std::make_shared<Specs>(*specs_);
+    specs->erase(std::remove_if(specs->begin(), specs->end(), [&name](const IndexSpec &candidate) {
+      return candidate.name == name;
+    }), specs->end());
+
+    count_.store(specs->size(), std::memory_order_release);
+    specs_ = specs;
+  }
+
+  if (!purge) {
+    return leveldb::Status::OK();
+  }
+
+  return Purge(db, name);
+}
+
+leveldb::Status SecondaryIndexes::Purge(leveldb::DB *db, const std::string &name) {
+  std::string prefix = NamePrefix(name);
+
+  leveldb::ReadOptions readOptions;
+  readOptions.fill_cache = false;
+
+  std::unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+  leveldb::WriteBatch batch;
+  size_t pending = 0;
+  leveldb::Status status;
+
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+    batch.Delete(it->key());
+
+    if (++pending == kRebuildChunkSize) {
+      status = db->Write(leveldb::WriteOptions(), &batch);
+      if (!status.ok()) {
+        return status;
+      }
+      batch.Clear();
+      pending = 0;
+    }
+  }
+
+  status = it->status();
+  if (status.ok() && pending > 0) {
+    status = db->Write(leveldb::WriteOptions(), &batch);
+  }
+
+  return status;
+}
+
+leveldb::Status SecondaryIndexes::AddEntries(leveldb::DB *db, const BatchOps &ops, leveldb::WriteBatch *out) {
+  std::shared_ptr<const Specs> specs = CurrentSpecs();
+  if (specs->empty()) {
+    return leveldb::Status::OK();
+  }
+
+  // Keys touched earlier in this batch: later operations must see them
+  // instead of what is in the database.
+  std::unordered_map<std::string, std::pair<bool, std::string>> touched;
+
+  std::string oldValue;
+  std::string oldIndexKey;
+  std::string newIndexKey;
+  leveldb::Status status;
+
+  for (const BatchOps::Op &op: ops.ops) {
+    if (op.key.starts_with(kKeyPrefix)) {
+      continue;
+    }
+
+    std::string key = op.key.ToString();
+    bool hadOld;
+
+    auto previous = touched.find(key);
+    if (previous != touched.end()) {
+      hadOld = previous->second.first;
+      oldValue = previous->second.second;
+    } else {
+      status = db->Get(leveldb::ReadOptions(), op.key, &oldValue);
+      if (!status.ok() && !status.IsNotFound()) {
+        return status;
+      }
+      hadOld = status.ok();
+    }
+
+    for (const IndexSpec &spec: *specs) {
+      bool hasOldEntry = hadOld && spec.Extract(op.key, oldValue, &oldIndexKey);
+      bool hasNewEntry = op.put && spec.Extract(op.key, op.value, &newIndexKey);
+
+      if (hasOldEntry && hasNewEntry && oldIndexKey == newIndexKey) {
+        continue;
+      }
+
+      if (hasOldEntry) {
+        out->Delete(EntryPrefix(spec.name, oldIndexKey) + key);
+      }
+
+      if (hasNewEntry) {
+        out->Put(EntryPrefix(spec.name, newIndexKey) + key, leveldb::Slice());
+      }
+    }
+
+    touched[key] = std::make_pair(op.put, op.put ? op.value.ToString() : std::string());
+  }
+
+  return leveldb::Status::OK();
+}
+
+leveldb::Status SecondaryIndexes::Lookup(leveldb::DB *db,
+                                         const leveldb::Snapshot *snapshot,
+                                         const std::string &name,
+                                         const leveldb::Slice &indexKey,
+                                         size_t limit,
+                                         std::vector<std::string> *values) {
+  IndexSpec spec;
+  if (!FindSpec(name, &spec)) {
+    return leveldb::Status::InvalidArgument("No such index", name);
+  }
+
+  // Entries and records must come from the same state of the database.
+  const leveldb::Snapshot *implicitSnapshot = nullptr;
+  if (snapshot == nullptr) {
+    implicitSnapshot = db->GetSnapshot();
+    snapshot = implicitSnapshot;
+  }
+
+  leveldb::ReadOptions readOptions;
+  readOptions.snapshot = snapshot;
+
+  std::string prefix = EntryPrefix(name, indexKey);
+  std::string primaryKey;
+  std::string value;
+  std::string extracted;
+  leveldb::Status status;
+
+  {
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      primaryKey.assign(it->key().data() + prefix.size(), it->key().size() - prefix.size());
+
+      status = db->Get(readOptions, primaryKey, &value);
+      if (status.IsNotFound()) {
+        status = leveldb::Status::OK();
+        continue;
+      } else if (!status.ok()) {
+        break;
+      }
+
+      // The record may have changed while the index was not registered.
+      if (!spec.Extract(primaryKey, value, &extracted) || extracted != indexKey) {
+        continue;
+      }
+
+      values->push_back(value);
+
+      if (limit != 0 && values->size() >= limit) {
+        break;
+      }
+    }
+
+    if (status.ok()) {
+      status = it->status();
+    }
+  }
+
+  if (implicitSnapshot != nullptr) {
+    db->ReleaseSnapshot(implicitSnapshot);
+  }
+
+  return status;
+}
+
+leveldb::Status SecondaryIndexes::Rebuild(leveldb::DB *db, const std::string &name, int threads) {
+  IndexSpec spec;
+  if (!FindSpec(name, &spec)) {
+    return leveldb::Status::InvalidArgument("No such index", name);
+  }
+
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  leveldb::Status status = Purge(db, name);
+  if (!status.ok()) {
+    return status;
+  }
+
+  typedef std::vector<std::pair<std::string, std::string>> Chunk;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<Chunk> queue;
+  bool finished = false;
+
+  auto worker = [&]() {
+    std::string indexKey;
+
+    for (;;) {
+      Chunk chunk;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return !queue.empty() || finished; });
+
+        if (queue.empty()) {
+          return;
+        }
+
+        chunk = std::move(queue.front());
+        queue.pop_front();
+      }
+      changed.notify_all();
+
+      leveldb::WriteBatch batch;
+      for (const auto &record: chunk) {
+        if (spec.Extract(record.first, record.second, &indexKey)) {
+          batch.Put(EntryPrefix(spec.name, indexKey) + record.first, leveldb::Slice());
+        }
+      }
+
+      leveldb::Status written = db->Write(leveldb::WriteOptions(), &batch);
+      if (!written.ok()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (status.ok()) {
+          status = written;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.emplace_back(worker);
+  }
+
+  // The snapshot hides the entries the workers are writing meanwhile.
+  leveldb::ReadOptions readOptions;
+  readOptions.fill_cache = false;
+  readOptions.snapshot = db->GetSnapshot();
+
+  {
+    std::unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+    Chunk chunk;
+
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (it->key().starts_with(kKeyPrefix)) {
+        continue;
+      }
+
+      chunk.emplace_back(it->key().ToString(), it->value().ToString());
+
+      if (chunk.size() == kRebuildChunkSize) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return queue.size() < (size_t) threads * 2 || !status.ok(); });
+
+        if (!status.ok()) {
+          break;
+        }
+
+        queue.push_back(std::move(chunk));
+        chunk = Chunk();
+        changed.notify_all();
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (status.ok()) {
+      status = it->status();
+    }
+    if (status.ok() && !chunk.empty()) {
+      queue.push_back(std::move(chunk));
+    }
+    finished = true;
+  }
+  changed.notify_all();
+
+  for (std::thread &thread: workers) {
+    thread.join();
+  }
+
+  db->ReleaseSnapshot(readOptions.snapshot);
+
+  return status;
+}
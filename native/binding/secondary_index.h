@@ -0,0 +1,105 @@
+#ifndef LEVELDB_ANDROID_SECONDARY_INDEX_H
+#define LEVELDB_ANDROID_SECONDARY_INDEX_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+#include "leveldb/write_batch.h"
+#include "batch_ops.h"
+
+// Declarative description of a secondary index: which part of the record is
+// the index key. Must match IndexExtractor on the Kotlin side.
+struct IndexSpec {
+  enum Type {
+    VALUE_RANGE = 0,
+    VALUE_FIELD = 1,
+    KEY_RANGE = 2,
+    KEY_FIELD = 3,
+  };
+
+  std::string name;
+  int type = VALUE_RANGE;
+  // Byte offset for *_RANGE, field number for *_FIELD.
+  int offset = 0;
+  // Byte length for *_RANGE, negative means "up to the end".
+  int length = -1;
+  char delimiter = 0;
+
+  // Extracts the index key of the record. Returns false if the record is not
+  // covered by this index.
+  bool Extract(const leveldb::Slice &key, const leveldb::Slice &value, std::string *out) const;
+
+  bool operator==(const IndexSpec &other) const {
+    return name == other.name && type == other.type && offset == other.offset
+        && length == other.length && delimiter == other.delimiter;
+  }
+};
+
+// Keeps index entries in the same keyspace as the data, under a reserved
+// prefix. Every entry is "<prefix><name>\0<len><index key><primary key>" with
+// an empty value, so a lookup is a single prefix scan. Iterators handed to
+// users skip the entries, see HideEntries().
+class SecondaryIndexes {
+ public:
+  // Keys with this prefix are reserved for index entries, writes of such
+  // keys are rejected.
+  static const leveldb::Slice kKeyPrefix;
+  // First key after all index entries.
+  static const leveldb::Slice kKeyPrefixEnd;
+
+  // Wraps `iterator`, taking ownership, so that it skips index entries.
+  static leveldb::Iterator *HideEntries(leveldb::Iterator *iterator);
+
+  bool Empty() const {
+    return count_.load(std::memory_order_acquire) == 0;
+  }
+
+  // Registers or replaces the index with the same name. Replacing it with a
+  // different spec deletes the entries of the old one. Existing records are
+  // not indexed until Rebuild() is called. The caller must keep writers out
+  // until it's done.
+  leveldb::Status Register(leveldb::DB *db, const IndexSpec &spec);
+
+  // Unregisters the index and optionally deletes all of its entries. The
+  // caller must keep writers out until it's done.
+  leveldb::Status Drop(leveldb::DB *db, const std::string &name, bool purge);
+
+  // Appends the index entries implied by `ops` to `out`. The caller must hold
+  // the key locks of all the keys in `ops`.
+  leveldb::Status AddEntries(leveldb::DB *db, const BatchOps &ops, leveldb::WriteBatch *out);
+
+  // Collects values of the records whose index key equals `indexKey`. Zero
+  // `limit` means no limit. Entries left behind by writes made while the
+  // index was not registered are skipped, they go away on Rebuild().
+  leveldb::Status Lookup(leveldb::DB *db,
+                         const leveldb::Snapshot *snapshot,
+                         const std::string &name,
+                         const leveldb::Slice &indexKey,
+                         size_t limit,
+                         std::vector<std::string> *values);
+
+  // Drops all entries of the index and re-creates them from the data, using
+  // up to `threads` workers. The caller must keep writers out until it's done.
+  leveldb::Status Rebuild(leveldb::DB *db, const std::string &name, int threads);
+
+ private:
+  typedef std::vector<IndexSpec> Specs;
+
+  std::shared_ptr<const Specs> CurrentSpecs() const;
+  bool FindSpec(const std::string &name, IndexSpec *spec) const;
+
+  static std::string EntryPrefix(const std::string &name, const leveldb::Slice &indexKey);
+  static std::string NamePrefix(const std::string &name);
+  static leveldb::Status Purge(leveldb::DB *db, const std::string &name);
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<const Specs> specs_ = std::make_shared<Specs>();
+  std::atomic<size_t> count_{0};
+};
+
+#endif //LEVELDB_ANDROID_SECONDARY_INDEX_H
@@ -0,0 +1,44 @@
+#include "snapshot_registry.h"
+
+const leveldb::Snapshot *SnapshotRegistry::Acquire(leveldb::DB *db, uint64_t sequence) {
+  const leveldb::Snapshot *snapshot = db->GetSnapshot();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshots_[snapshot] = Entry{sequence, env_->NowMicros()};
+
+  return snapshot;
+}
+
+void SnapshotRegistry::Release(leveldb::DB *db, const leveldb::Snapshot *snapshot) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (snapshots_.erase(snapshot) == 0) {
+      return;
+    }
+  }
+
+  db->ReleaseSnapshot(snapshot);
+}
+
+SnapshotRegistry::Stats SnapshotRegistry::GetStats() const {
+  Stats stats;
+  uint64_t now = env_->NowMicros();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.count = snapshots_.size();
+
+  // Few snapshots are open at a time, a scan is cheaper than keeping them ordered.
+  const Entry *oldest = nullptr;
+  for (const auto &snapshot: snapshots_) {
+    if (oldest == nullptr || snapshot.second.createdMicros < oldest->createdMicros) {
+      oldest = &snapshot.second;
+    }
+  }
+
+  if (oldest != nullptr) {
+    stats.oldestSequence = oldest->sequence;
+    stats.oldestAgeMicros = now > oldest->createdMicros ? now - oldest->createdMicros : 0;
+  }
+
+  return stats;
+}
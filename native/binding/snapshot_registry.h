@@ -0,0 +1,49 @@
+#ifndef LEVELDB_ANDROID_SNAPSHOT_REGISTRY_H
+#define LEVELDB_ANDROID_SNAPSHOT_REGISTRY_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+
+// Keeps track of the snapshots handed out by the binding. A snapshot that is
+// never released keeps compactions from dropping the versions it can see, so
+// the database grows silently; the stats make that visible.
+class SnapshotRegistry {
+ public:
+  struct Stats {
+    uint64_t count = 0;
+    // LastSequence() of the binding when the oldest snapshot was taken.
+    uint64_t oldestSequence = 0;
+    uint64_t oldestAgeMicros = 0;
+  };
+
+  explicit SnapshotRegistry(leveldb::Env *env) : env_(env) {}
+
+  SnapshotRegistry(const SnapshotRegistry &) = delete;
+  SnapshotRegistry &operator=(const SnapshotRegistry &) = delete;
+
+  // Takes a snapshot of `db`, which sees at least the writes up to `sequence`.
+  const leveldb::Snapshot *Acquire(leveldb::DB *db, uint64_t sequence);
+
+  // Releases a snapshot taken by Acquire(). Unknown snapshots are ignored,
+  // so a snapshot is never released twice.
+  void Release(leveldb::DB *db, const leveldb::Snapshot *snapshot);
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    uint64_t sequence;
+    uint64_t createdMicros;
+  };
+
+  leveldb::Env *const env_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<const leveldb::Snapshot *, Entry> snapshots_;
+};
+
+#endif //LEVELDB_ANDROID_SNAPSHOT_REGISTRY_H
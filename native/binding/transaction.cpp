@@ -0,0 +1,47 @@
+#include "transaction.h"
+
+// The sequence is taken before the snapshot: writes up to it are all in the
+// snapshot, the ones racing with us only make the validation stricter. The
+// snapshot is registered like the ones handed to Kotlin, so that a
+// transaction left open shows up in the snapshot stats.
+Transaction::Transaction(NDBHolder *holder)
+    : holder_(holder),
+      startSequence_(holder->LastSequence()),
+      snapshot_(holder->snapshots.Acquire(holder->db, startSequence_)) {}
+
+Transaction::~Transaction() {
+  holder_->snapshots.Release(holder_->db, snapshot_);
+}
+
+leveldb::Status Transaction::Get(const leveldb::Slice &key, std::string *value) {
+  auto written = writes_.find(key.ToString());
+  if (written != writes_.end()) {
+    if (!written->second.first) {
+      return leveldb::Status::NotFound(key);
+    }
+
+    *value = written->second.second;
+    return leveldb::Status::OK();
+  }
+
+  readStripes_.push_back(KeyLocks::StripeOf(key));
+
+  leveldb::ReadOptions readOptions;
+  readOptions.snapshot = snapshot_;
+
+  return holder_->db->Get(readOptions, key, value);
+}
+
+void Transaction::Put(const leveldb::Slice &key, const leveldb::Slice &value) {
+  batch_.Put(key, value);
+  writes_[key.ToString()] = std::make_pair(true, value.ToString());
+}
+
+void Transaction::Delete(const leveldb::Slice &key) {
+  batch_.Delete(key);
+  writes_[key.ToString()] = std::make_pair(false, std::string());
+}
+
+leveldb::Status Transaction::Commit(const leveldb::WriteOptions &options, bool *conflict) {
+  return holder_->Commit(options, &batch_, readStripes_, startSequence_, conflict);
+}
@@ -0,0 +1,47 @@
+#ifndef LEVELDB_ANDROID_TRANSACTION_H
+#define LEVELDB_ANDROID_TRANSACTION_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+#include "ndb_holder.h"
+
+// Optimistic transaction. Reads come from the snapshot taken at the start,
+// writes are buffered in a WriteBatch and applied on Commit(), but only if no
+// key that was read has been written by somebody else in the meantime.
+//
+// Conflicts are detected per lock stripe, so an unrelated key sharing a stripe
+// with a read key may cause a spurious conflict. Not thread safe.
+class Transaction {
+ public:
+  explicit Transaction(NDBHolder *holder);
+  ~Transaction();
+
+  Transaction(const Transaction &) = delete;
+  Transaction &operator=(const Transaction &) = delete;
+
+  // Sees the writes of this transaction, and the database as of the start.
+  leveldb::Status Get(const leveldb::Slice &key, std::string *value);
+
+  void Put(const leveldb::Slice &key, const leveldb::Slice &value);
+  void Delete(const leveldb::Slice &key);
+
+  leveldb::Status Commit(const leveldb::WriteOptions &options, bool *conflict);
+
+ private:
+  NDBHolder *holder_;
+  uint64_t startSequence_;
+  const leveldb::Snapshot *snapshot_;
+
+  leveldb::WriteBatch batch_;
+  // Latest buffered state of every written key: exists + value.
+  std::unordered_map<std::string, std::pair<bool, std::string>> writes_;
+  std::vector<size_t> readStripes_;
+};
+
+#endif //LEVELDB_ANDROID_TRANSACTION_H
@@ -0,0 +1,420 @@
+#include "transfer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef LEVELDB_JNI_ZLIB
+#include <zlib.h>
+#endif
+
+#include "util/crc32c.h"
+
+namespace {
+
+const char kMagic[4] = {'L', 'D', 'B', 'X'};
+const uint8_t kVersion = 1;
+const uint8_t kFlagZlib = 1;
+
+const size_t kHeaderSize = 8;
+const size_t kBlockHeaderSize = 12;
+// Sanity limit of a block, so that a corrupt length doesn't make us allocate gigabytes.
+const uint32_t kMaxBlockSize = 1u << 30;
+
+void PutFixed32(std::string *dst, uint32_t value) {
+  char buf[4];
+  for (int i = 0; i < 4; i++) {
+    buf[i] = (char) (value >> (8 * i));
+  }
+  dst->append(buf, 4);
+}
+
+void PutFixed64(std::string *dst, uint64_t value) {
+  PutFixed32(dst, (uint32_t) value);
+  PutFixed32(dst, (uint32_t) (value >> 32));
+}
+
+uint32_t DecodeFixed32(const char *ptr) {
+  const uint8_t *p = (const uint8_t *) ptr;
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+uint64_t DecodeFixed64(const char *ptr) {
+  return (uint64_t) DecodeFixed32(ptr) | ((uint64_t) DecodeFixed32(ptr + 4) << 32);
+}
+
+void PutVarint32(std::string *dst, uint32_t value) {
+  while (value >= 0x80) {
+    dst->push_back((char) (value | 0x80));
+    value >>= 7;
+  }
+  dst->push_back((char) value);
+}
+
+bool GetVarint32(const char **p, const char *limit, uint32_t *value) {
+  uint32_t result = 0;
+  for (uint32_t shift = 0; shift <= 28 && *p < limit; shift += 7) {
+    uint32_t byte = (uint8_t) **p;
+    (*p)++;
+    result |= (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GetLengthPrefixed(const char **p, const char *limit, leveldb::Slice *result) {
+  uint32_t length;
+  if (!GetVarint32(p, limit, &length) || (size_t) (limit - *p) < length) {
+    return false;
+  }
+  *result = leveldb::Slice(*p, length);
+  *p += length;
+  return true;
+}
+
+#ifndef _WIN32
+class FdSink final: public TransferSink {
+ public:
+  explicit FdSink(int fd) : fd_(fd) {}
+
+  leveldb::Status Write(const char *data, size_t n) override {
+    while (n > 0) {
+      ssize_t written = ::write(fd_, data, n);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return leveldb::Status::IOError("write", strerror(errno));
+      }
+      data += written;
+      n -= (size_t) written;
+    }
+    return leveldb::Status::OK();
+  }
+
+ private:
+  const int fd_;
+};
+
+class FdSource final: public TransferSource {
+ public:
+  explicit FdSource(int fd) : fd_(fd) {}
+
+  leveldb::Status Read(char *scratch, size_t n, size_t *read) override {
+    for (;;) {
+      ssize_t count = ::read(fd_, scratch, n);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return leveldb::Status::IOError("read", strerror(errno));
+      }
+      *read = (size_t) count;
+      return leveldb::Status::OK();
+    }
+  }
+
+ private:
+  const int fd_;
+};
+#endif
+
+class FileSink final: public TransferSink {
+ public:
+  explicit FileSink(leveldb::WritableFile *file) : file_(file) {}
+
+  leveldb::Status Write(const char *data, size_t n) override {
+    return file_->Append(leveldb::Slice(data, n));
+  }
+
+  leveldb::Status Close() override {
+    return file_->Close();
+  }
+
+ private:
+  std::unique_ptr<leveldb::WritableFile> file_;
+};
+
+class FileSource final: public TransferSource {
+ public:
+  explicit FileSource(leveldb::SequentialFile *file) : file_(file) {}
+
+  leveldb::Status Read(char *scratch, size_t n, size_t *read) override {
+    leveldb::Slice result;
+    leveldb::Status status = file_->Read(n, &result, scratch);
+    if (status.ok()) {
+      // Files may return data in their own buffer.
+      if (result.data() != scratch) {
+        memcpy(scratch, result.data(), result.size());
+      }
+      *read = result.size();
+    }
+    return status;
+  }
+
+ private:
+  std::unique_ptr<leveldb::SequentialFile> file_;
+};
+
+} // namespace
+
+leveldb::Status NewFdSink(int fd, std::unique_ptr<TransferSink> *result) {
+#ifndef _WIN32
+  result->reset(new FdSink(fd));
+  return leveldb::Status::OK();
+#else
+  return leveldb::Status::NotSupported("File descriptors are not supported on Windows");
+#endif
+}
+
+leveldb::Status NewFdSource(int fd, std::unique_ptr<TransferSource> *result) {
+#ifndef _WIN32
+  result->reset(new FdSource(fd));
+  return leveldb::Status::OK();
+#else
+  return leveldb::Status::NotSupported("File descriptors are not supported on Windows");
+#endif
+}
+
+leveldb::Status NewFileSink(leveldb::Env *env, const std::string &path, std::unique_ptr<TransferSink> *result) {
+  leveldb::WritableFile *file;
+  leveldb::Status status = env->NewWritableFile(path, &file);
+  if (status.ok()) {
+    result->reset(new FileSink(file));
+  }
+  return status;
+}
+
+leveldb::Status NewFileSource(leveldb::Env *env, const std::string &path, std::unique_ptr<TransferSource> *result) {
+  leveldb::SequentialFile *file;
+  leveldb::Status status = env->NewSequentialFile(path, &file);
+  if (status.ok()) {
+    result->reset(new FileSource(file));
+  }
+  return status;
+}
+
+bool TransferWriter::CompressionSupported() {
+#ifdef LEVELDB_JNI_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+leveldb::Status TransferWriter::Begin() {
+  if (compress_ && !CompressionSupported()) {
+    return leveldb::Status::NotSupported("Built without zlib, export without compression");
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  header.push_back((char) kVersion);
+  header.push_back((char) (compress_ ? kFlagZlib : 0));
+  header.append(2, '\0');
+
+  raw_.reserve(kBlockSize + kBlockSize / 8);
+  return Emit(header);
+}
+
+leveldb::Status TransferWriter::Add(const leveldb::Slice &key, const leveldb::Slice &value) {
+  if (!raw_.empty() && raw_.size() + key.size() + value.size() + 10 > kBlockSize) {
+    leveldb::Status status = FlushBlock();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  PutVarint32(&raw_, (uint32_t) key.size());
+  raw_.append(key.data(), key.size());
+  PutVarint32(&raw_, (uint32_t) value.size());
+  raw_.append(value.data(), value.size());
+  stats_.records++;
+  return leveldb::Status::OK();
+}
+
+leveldb::Status TransferWriter::Finish() {
+  leveldb::Status status = FlushBlock();
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::string count;
+  PutFixed64(&count, stats_.records);
+
+  out_.clear();
+  PutFixed32(&out_, 0);
+  PutFixed32(&out_, 0);
+  PutFixed32(&out_, leveldb::crc32c::Mask(leveldb::crc32c::Value(count.data(), count.size())));
+  out_.append(count);
+  return Emit(out_);
+}
+
+leveldb::Status TransferWriter::FlushBlock() {
+  if (raw_.empty()) {
+    return leveldb::Status::OK();
+  }
+
+  // Block header first, filled in once the stored size is known.
+  out_.assign(kBlockHeaderSize, '\0');
+
+  if (compress_) {
+#ifdef LEVELDB_JNI_ZLIB
+    uLongf stored = compressBound((uLong) raw_.size());
+    out_.resize(kBlockHeaderSize + stored);
+    int rc = compress2((Bytef *) &out_[kBlockHeaderSize], &stored,
+                       (const Bytef *) raw_.data(), (uLong) raw_.size(), Z_BEST_SPEED);
+    if (rc != Z_OK) {
+      return leveldb::Status::IOError("zlib compression failed");
+    }
+    out_.resize(kBlockHeaderSize + stored);
+#endif
+  } else {
+    out_.append(raw_);
+  }
+
+  size_t stored = out_.size() - kBlockHeaderSize;
+  std::string header;
+  PutFixed32(&header, (uint32_t) stored);
+  PutFixed32(&header, (uint32_t) raw_.size());
+  PutFixed32(&header, leveldb::crc32c::Mask(leveldb::crc32c::Value(out_.data() + kBlockHeaderSize, stored)));
+  memcpy(&out_[0], header.data(), kBlockHeaderSize);
+
+  raw_.clear();
+  return Emit(out_);
+}
+
+leveldb::Status TransferWriter::Emit(const std::string &data) {
+  stats_.bytes += data.size();
+  return sink_->Write(data.data(), data.size());
+}
+
+leveldb::Status TransferReader::ReadFully(char *scratch, size_t n) {
+  while (n > 0) {
+    size_t read = 0;
+    leveldb::Status status = source_->Read(scratch, n, &read);
+    if (!status.ok()) {
+      return status;
+    }
+    if (read == 0) {
+      return leveldb::Status::Corruption("Export stream is truncated");
+    }
+    scratch += read;
+    n -= read;
+    stats_.bytes += read;
+  }
+  return leveldb::Status::OK();
+}
+
+leveldb::Status TransferReader::Begin() {
+  char header[kHeaderSize];
+  leveldb::Status status = ReadFully(header, sizeof(header));
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+    return leveldb::Status::Corruption("Not an export stream");
+  }
+  if ((uint8_t) header[4] != kVersion) {
+    return leveldb::Status::NotSupported("Unknown export stream version");
+  }
+
+  uint8_t flags = (uint8_t) header[5];
+  if ((flags & ~kFlagZlib) != 0) {
+    return leveldb::Status::NotSupported("Unknown export stream flags");
+  }
+  compressed_ = (flags & kFlagZlib) != 0;
+  if (compressed_ && !TransferWriter::CompressionSupported()) {
+    return leveldb::Status::NotSupported("Export stream is compressed, but built without zlib");
+  }
+  return leveldb::Status::OK();
+}
+
+leveldb::Status TransferReader::ReadBlock(bool *trailer) {
+  char header[kBlockHeaderSize];
+  leveldb::Status status = ReadFully(header, sizeof(header));
+  if (!status.ok()) {
+    return status;
+  }
+
+  uint32_t storedSize = DecodeFixed32(header);
+  uint32_t rawSize = DecodeFixed32(header + 4);
+  uint32_t crc = leveldb::crc32c::Unmask(DecodeFixed32(header + 8));
+
+  if (storedSize == 0 && rawSize == 0) {
+    char count[8];
+    status = ReadFully(count, sizeof(count));
+    if (!status.ok()) {
+      return status;
+    }
+    if (leveldb::crc32c::Value(count, sizeof(count)) != crc) {
+      return leveldb::Status::Corruption("Export stream trailer checksum mismatch");
+    }
+    if (DecodeFixed64(count) != stats_.records) {
+      return leveldb::Status::Corruption("Export stream record count mismatch");
+    }
+    *trailer = true;
+    return leveldb::Status::OK();
+  }
+
+  if (storedSize > kMaxBlockSize || rawSize > kMaxBlockSize || (!compressed_ && storedSize != rawSize)) {
+    return leveldb::Status::Corruption("Export stream block size is invalid");
+  }
+
+  stored_.resize(storedSize);
+  status = ReadFully(&stored_[0], storedSize);
+  if (!status.ok()) {
+    return status;
+  }
+  if (leveldb::crc32c::Value(stored_.data(), storedSize) != crc) {
+    return leveldb::Status::Corruption("Export stream block checksum mismatch");
+  }
+
+  if (compressed_) {
+#ifdef LEVELDB_JNI_ZLIB
+    raw_.resize(rawSize);
+    uLongf size = rawSize;
+    int rc = uncompress((Bytef *) &raw_[0], &size, (const Bytef *) stored_.data(), (uLong) storedSize);
+    if (rc != Z_OK || size != rawSize) {
+      return leveldb::Status::Corruption("Export stream block doesn't decompress");
+    }
+#endif
+  } else {
+    raw_.swap(stored_);
+  }
+
+  pos_ = 0;
+  *trailer = false;
+  return leveldb::Status::OK();
+}
+
+leveldb::Status TransferReader::Next(leveldb::Slice *key, leveldb::Slice *value, bool *done) {
+  while (pos_ >= raw_.size()) {
+    bool trailer = false;
+    leveldb::Status status = ReadBlock(&trailer);
+    if (!status.ok()) {
+      return status;
+    }
+    if (trailer) {
+      *done = true;
+      return leveldb::Status::OK();
+    }
+  }
+
+  const char *p = raw_.data() + pos_;
+  const char *limit = raw_.data() + raw_.size();
+  if (!GetLengthPrefixed(&p, limit, key) || !GetLengthPrefixed(&p, limit, value)) {
+    return leveldb::Status::Corruption("Export stream record is invalid");
+  }
+
+  pos_ = (size_t) (p - raw_.data());
+  stats_.records++;
+  *done = false;
+  return leveldb::Status::OK();
+}
@@ -0,0 +1,125 @@
+#ifndef LEVELDB_ANDROID_TRANSFER_H
+#define LEVELDB_ANDROID_TRANSFER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+// Stream format of exported records, written and read in one pass:
+//
+//   header:  "LDBX" | version (1 byte) | flags (1 byte, 1 = zlib) | 2 zero bytes
+//   block:   stored length | raw length | masked crc32c of the stored bytes
+//            (fixed32 each) | stored bytes
+//   trailer: two zero fixed32 | masked crc32c of the count | record count (fixed64)
+//
+// The raw bytes of a block are records, "varint32 key length | key | varint32
+// value length | value", stored deflated with the zlib flag. Records never
+// span blocks. The trailer tells a complete stream from a truncated one.
+
+struct TransferStats {
+  uint64_t records = 0;
+  // Bytes of the stream.
+  uint64_t bytes = 0;
+  // Records of the stream not imported because their keys are reserved for
+  // index entries. Not included in `records`.
+  uint64_t skipped = 0;
+};
+
+class TransferSink {
+ public:
+  virtual ~TransferSink() = default;
+
+  virtual leveldb::Status Write(const char *data, size_t n) = 0;
+
+  // Called once after the last write.
+  virtual leveldb::Status Close() {
+    return leveldb::Status::OK();
+  }
+};
+
+class TransferSource {
+ public:
+  virtual ~TransferSource() = default;
+
+  // Reads up to `n` bytes, setting `read` to 0 only at the end of the stream.
+  virtual leveldb::Status Read(char *scratch, size_t n, size_t *read) = 0;
+};
+
+// Sink and source on a file descriptor the caller owns, e.g. a socket or a
+// pipe. Not supported on Windows.
+leveldb::Status NewFdSink(int fd, std::unique_ptr<TransferSink> *result);
+leveldb::Status NewFdSource(int fd, std::unique_ptr<TransferSource> *result);
+
+// Sink and source on a file of `env`, which the sink creates or truncates.
+leveldb::Status NewFileSink(leveldb::Env *env, const std::string &path, std::unique_ptr<TransferSink> *result);
+leveldb::Status NewFileSource(leveldb::Env *env, const std::string &path, std::unique_ptr<TransferSource> *result);
+
+class TransferWriter {
+ public:
+  // Raw bytes a block is cut at. A larger record gets a block of its own.
+  static const size_t kBlockSize = 1 << 20;
+
+  // Whether the library has been built with zlib.
+  static bool CompressionSupported();
+
+  TransferWriter(TransferSink *sink, bool compress) : sink_(sink), compress_(compress) {}
+
+  TransferWriter(const TransferWriter &) = delete;
+  TransferWriter &operator=(const TransferWriter &) = delete;
+
+  leveldb::Status Begin();
+  leveldb::Status Add(const leveldb::Slice &key, const leveldb::Slice &value);
+  // Writes the last block and the trailer.
+  leveldb::Status Finish();
+
+  const TransferStats &Stats() const {
+    return stats_;
+  }
+
+ private:
+  leveldb::Status FlushBlock();
+  leveldb::Status Emit(const std::string &data);
+
+  TransferSink *sink_;
+  const bool compress_;
+
+  std::string raw_;
+  std::string out_;
+  TransferStats stats_;
+};
+
+class TransferReader {
+ public:
+  explicit TransferReader(TransferSource *source) : source_(source) {}
+
+  TransferReader(const TransferReader &) = delete;
+  TransferReader &operator=(const TransferReader &) = delete;
+
+  leveldb::Status Begin();
+
+  // Reads the next record, valid until the next call, or sets `done` at the
+  // trailer. A stream that ends before its trailer is Corruption.
+  leveldb::Status Next(leveldb::Slice *key, leveldb::Slice *value, bool *done);
+
+  const TransferStats &Stats() const {
+    return stats_;
+  }
+
+ private:
+  leveldb::Status ReadFully(char *scratch, size_t n);
+  leveldb::Status ReadBlock(bool *trailer);
+
+  TransferSource *source_;
+  bool compressed_ = false;
+
+  std::string stored_;
+  std::string raw_;
+  size_t pos_ = 0;
+  TransferStats stats_;
+};
+
+#endif //LEVELDB_ANDROID_TRANSFER_H
@@ -0,0 +1,117 @@
+#include "write_pressure.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Base delay of the throttle, at kL0CompactionTrigger files.
+const uint64_t kThrottleBaseMicros = 100;
+
+struct ThreadWrite {
+  WritePressure *pressure = nullptr;
+  bool stalled = false;
+  uint64_t stallStart = 0;
+};
+
+thread_local ThreadWrite threadWrite;
+
+bool StartsWith(const char *format, const char *prefix) {
+  return strncmp(format, prefix, strlen(prefix)) == 0;
+}
+
+} // namespace
+
+uint64_t WritePressure::NowMicros() {
+  return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void WritePressure::OnLog(const char *format) {
+  // Anything leveldb logs is about flushes, compactions or stalls, all of
+  // which may change the level-0 file count.
+  l0Stale_.store(true, std::memory_order_release);
+
+  if (StartsWith(format, "Level-0 table #")) {
+    flushing_.store(strstr(format, "started") != nullptr, std::memory_order_release);
+    return;
+  }
+
+  bool memtableFull = StartsWith(format, "Current memtable full; waiting");
+  if (memtableFull || StartsWith(format, "Too many L0 files; waiting")) {
+    ThreadWrite &write = threadWrite;
+    if (write.pressure == this && !write.stalled) {
+      write.stalled = true;
+      write.stallStart = NowMicros();
+      activeStalls_.fetch_add(1, std::memory_order_acq_rel);
+      Report(DBEvent::STALL_STARTED, memtableFull ? 0 : 1);
+    }
+  }
+}
+
+void WritePressure::Report(DBEvent::Type type, int64_t value) {
+  if (events_ != nullptr && events_->Enabled()) {
+    events_->Push(DBEvent{type, 0, value, 0, 0, 0});
+  }
+}
+
+int WritePressure::L0Files(leveldb::DB *db) {
+  if (l0Stale_.exchange(false, std::memory_order_acq_rel)) {
+    std::string value;
+    if (db->GetProperty("leveldb.num-files-at-level0", &value)) {
+      l0Files_.store(atoi(value.c_str()), std::memory_order_release);
+    }
+  }
+
+  return l0Files_.load(std::memory_order_acquire);
+}
+
+uint64_t WritePressure::ThrottleDelayMicros(leveldb::DB *db) {
+  int files = L0Files(db);
+  if (files < kL0CompactionTrigger || files >= kL0SlowdownWritesTrigger) {
+    return 0;
+  }
+
+  return kThrottleBaseMicros << (files - kL0CompactionTrigger);
+}
+
+uint64_t WritePressure::RetryAfterMillis(leveldb::DB *db) {
+  if (StalledWriters() > 0) {
+    // Expect the current stall to last about as long as the previous ones.
+    uint64_t stalls = Stalls();
+    uint64_t average = stalls == 0 ? 0 : StallMicros() / stalls / 1000;
+    return average < 1 ? 1 : average;
+  }
+
+  int files = L0Files(db);
+  if (files >= kL0SlowdownWritesTrigger) {
+    // leveldb delays every write by 1ms here, and blocks from kL0StopWritesTrigger.
+    return (uint64_t) (files - kL0SlowdownWritesTrigger + 1);
+  }
+
+  return 0;
+}
+
+WritePressure::WriteScope::WriteScope(WritePressure *pressure) : pressure_(pressure) {
+  threadWrite.pressure = pressure;
+  threadWrite.stalled = false;
+  pressure_->writers_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+WritePressure::WriteScope::~WriteScope() {
+  ThreadWrite &write = threadWrite;
+
+  if (write.stalled) {
+    uint64_t micros = NowMicros() - write.stallStart;
+    pressure_->stalls_.fetch_add(1, std::memory_order_relaxed);
+    pressure_->stallMicros_.fetch_add(micros, std::memory_order_relaxed);
+    pressure_->activeStalls_.fetch_sub(1, std::memory_order_acq_rel);
+    pressure_->Report(DBEvent::STALL_ENDED, (int64_t) micros);
+  }
+
+  write.pressure = nullptr;
+  write.stalled = false;
+  pressure_->writers_.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,110 @@
+#ifndef LEVELDB_ANDROID_WRITE_PRESSURE_H
+#define LEVELDB_ANDROID_WRITE_PRESSURE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "leveldb/db.h"
+#include "event_queue.h"
+
+// Tracks how close leveldb is to stalling writers. leveldb doesn't report
+// flushes or stalls other than in its info log, so the logger feeds the log
+// formats in here; the level-0 file count comes from a property, re-read
+// only after leveldb has logged something, i.e. after a flush or compaction.
+class WritePressure {
+ public:
+  // Stalls are reported to `events`, if given.
+  explicit WritePressure(EventQueue *events = nullptr) : events_(events) {}
+
+  // Mirror leveldb's db/dbformat.h, which is not public.
+  static const int kL0CompactionTrigger = 4;
+  static const int kL0SlowdownWritesTrigger = 8;
+  static const int kL0StopWritesTrigger = 12;
+
+  // Called for every info log message with its format string.
+  void OnLog(const char *format);
+
+  int L0Files(leveldb::DB *db);
+
+  // Makes the next L0Files() read the property again, even if leveldb
+  // hasn't logged anything since.
+  void RefreshL0Files() {
+    l0Stale_.store(true, std::memory_order_release);
+  }
+
+  bool Flushing() const {
+    return flushing_.load(std::memory_order_acquire);
+  }
+
+  // Number of writers leveldb is making wait right now. Only the writer
+  // that leads a group commit logs the stall, but while it waits every other
+  // write is queued behind it, so all writers in a WriteScope count.
+  int StalledWriters() const {
+    return activeStalls_.load(std::memory_order_acquire) > 0 ? writers_.load(std::memory_order_acquire) : 0;
+  }
+
+  // Delay that spreads writes out while level-0 fills up towards
+  // kL0SlowdownWritesTrigger, doubling with every extra file. Zero below
+  // kL0CompactionTrigger files and from the trigger on, where leveldb
+  // takes over.
+  uint64_t ThrottleDelayMicros(leveldb::DB *db);
+
+  // Zero if a write would go through without waiting now, otherwise a hint
+  // in milliseconds when to try again.
+  uint64_t RetryAfterMillis(leveldb::DB *db);
+
+  void RecordThrottle(uint64_t micros) {
+    throttledWrites_.fetch_add(1, std::memory_order_relaxed);
+    throttleMicros_.fetch_add(micros, std::memory_order_relaxed);
+  }
+
+  uint64_t Stalls() const {
+    return stalls_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t StallMicros() const {
+    return stallMicros_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t ThrottledWrites() const {
+    return throttledWrites_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t ThrottleMicros() const {
+    return throttleMicros_.load(std::memory_order_relaxed);
+  }
+
+  // Wraps a write to the database: a stall leveldb logs on this thread while
+  // the scope is alive is counted and timed. Also counts the writers.
+  class WriteScope {
+   public:
+    explicit WriteScope(WritePressure *pressure);
+    ~WriteScope();
+
+    WriteScope(const WriteScope &) = delete;
+    WriteScope &operator=(const WriteScope &) = delete;
+
+   private:
+    WritePressure *pressure_;
+  };
+
+ private:
+  static uint64_t NowMicros();
+
+  void Report(DBEvent::Type type, int64_t value);
+
+  EventQueue *events_;
+  std::atomic<bool> flushing_{false};
+  std::atomic<bool> l0Stale_{true};
+  std::atomic<int> l0Files_{0};
+  // Writers in a WriteScope, and those of them that logged a stall.
+  std::atomic<int> writers_{0};
+  std::atomic<int> activeStalls_{0};
+
+  std::atomic<uint64_t> stalls_{0};
+  std::atomic<uint64_t> stallMicros_{0};
+  std::atomic<uint64_t> throttledWrites_{0};
+  std::atomic<uint64_t> throttleMicros_{0};
+};
+
+#endif //LEVELDB_ANDROID_WRITE_PRESSURE_H
@@ -7,6 +7,7 @@ include(
     ":example",
     ":leveldb-kt",
     ":leveldb-android",
+    ":benchmark",
 //    ":mdnsjni"
 )
 